@@ -30,6 +30,7 @@ Command to run:
 #include "signal.h"
 #include "XEP.hpp"
 #include "xtid.h"
+#include <chrono>
 #include <iostream>
 #if defined(_WIN32) || defined(__MINGW32__)
 #include <winsock2.h>
@@ -181,6 +182,9 @@ int print_radar_raw_data_message(ModuleConnector &mc)
 
     while (!stop_output)
     {
+        // Sleep until a frame is queued instead of spinning on peek_message_data_float
+        if (!xep.wait_for_message(FloatDataType, std::chrono::milliseconds(100)))
+            continue;
         while (xep.peek_message_data_float() > 0)
         {
             xep.read_message_data_float(&radar_raw_data);
@@ -228,6 +232,9 @@ int playback_radar_raw_data_message(DataPlayer &player)
 
     while (!stop_output)
     {
+        // Sleep until a frame is queued instead of spinning on peek_message_data_float
+        if (!xep.wait_for_message(FloatDataType, std::chrono::milliseconds(100)))
+            continue;
         while (xep.peek_message_data_float() > 0)
         {
             xep.read_message_data_float(&radar_raw_data);
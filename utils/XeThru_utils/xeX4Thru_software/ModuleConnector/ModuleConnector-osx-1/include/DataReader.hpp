@@ -7,6 +7,8 @@
 #include <string>
 #include <memory>
 #include <cinttypes>
+#include <cstddef>
+#include <iterator>
 
 namespace XeThru {
 
@@ -34,9 +36,15 @@ namespace XeThru {
  *
  * @snippet read_recording.cpp Typical usage with raw buffer
  *
+ * \ref records wraps the raw buffer loop in a range, reading each record into one buffer
+ * owned by the range:
+ *
+ * @snippet read_recording.cpp Typical usage with record range
+ *
  * @see DataRecorder, DataPlayer
  */
 class DataReaderPrivate;
+class RecordRange;
 class DataReader
 {
 public:
@@ -244,6 +252,20 @@ public:
      */
     uint32_t get_profile_id() const;
 
+    /**
+     * Returns a range over the remaining records matching \a data_types, for use in a
+     * range-based for loop. The filter is set as with \ref set_filter.
+     *
+     * The records are read into one buffer of \ref get_max_record_size bytes owned by the
+     * range, so iterating does not allocate. Each \ref RecordView is valid until the
+     * iterator is incremented.
+     *
+     * @param data_types Specifies the filter as a bitmask of \ref DataType flags.
+     * @return the RecordRange.
+     * @see RecordRange, read_record
+     */
+    inline RecordRange records(uint32_t data_types = AllDataTypes);
+
 private:
     DataReader(const DataReader &other) = delete;
     DataReader(DataReader &&other) = delete;
@@ -253,6 +275,108 @@ private:
     std::unique_ptr<DataReaderPrivate> d_ptr;
 };
 
+/**
+ * @class RecordRange
+ *
+ * Input range over the records of a \ref DataReader, returned by \ref DataReader::records.
+ *
+ * Iteration stops at the end of the recording or when reading fails; \ref has_failed
+ * tells the two apart. Only one iteration over a range is meaningful, since it consumes
+ * the records of the reader.
+ */
+class RecordRange
+{
+public:
+    class iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef RecordView value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const RecordView *pointer;
+        typedef const RecordView &reference;
+
+        iterator() : range(nullptr) {}
+
+        reference operator*() const { return range->view; }
+        pointer operator->() const { return &range->view; }
+
+        iterator & operator++()
+        {
+            if (!range->next())
+                range = nullptr;
+            return *this;
+        }
+
+        bool operator==(const iterator &other) const { return range == other.range; }
+        bool operator!=(const iterator &other) const { return range != other.range; }
+
+    private:
+        friend class RecordRange;
+        explicit iterator(RecordRange *record_range) : range(record_range) {}
+
+        RecordRange *range;
+    };
+
+    RecordRange(DataReader &data_reader, uint32_t data_types) :
+        reader(&data_reader),
+        buffer_size(data_reader.get_max_record_size()),
+        buffer(new uint8_t[buffer_size > 0 ? buffer_size : 1]),
+        failed(data_reader.set_filter(data_types) != 0)
+    {
+        view.data = buffer.get();
+        view.size = 0;
+        view.data_type = 0;
+        view.epoch = 0;
+        view.is_user_header = false;
+        view.meta_version = data_reader.get_meta_version();
+    }
+
+    RecordRange(RecordRange &&other) = default;
+
+    /**
+     * Reads the first record.
+     * @return an iterator to the first record, or \ref end if there is none.
+     */
+    iterator begin() { return next() ? iterator(this) : iterator(); }
+
+    iterator end() { return iterator(); }
+
+    /**
+     * @return true if iteration stopped because reading a record failed.
+     */
+    bool has_failed() const { return failed; }
+
+private:
+    RecordRange(const RecordRange &other) = delete;
+    RecordRange& operator= (const RecordRange &other) = delete;
+
+    bool next()
+    {
+        if (failed || reader->at_end())
+            return false;
+        uint8_t is_user_header = 0;
+        if (reader->read_record(buffer.get(), buffer_size, &view.size, &view.data_type,
+                                &view.epoch, &is_user_header) != 0) {
+            failed = true;
+            return false;
+        }
+        view.is_user_header = is_user_header != 0;
+        return true;
+    }
+
+    DataReader *reader;
+    uint32_t buffer_size;
+    std::unique_ptr<uint8_t[]> buffer;
+    RecordView view;
+    bool failed;
+};
+
+inline RecordRange DataReader::records(uint32_t data_types)
+{
+    return RecordRange(*this, data_types);
+}
+
 } // namespace XeThru
 
 #endif // DATAREADER_H
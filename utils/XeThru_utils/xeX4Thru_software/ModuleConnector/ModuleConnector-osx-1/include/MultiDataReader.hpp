@@ -0,0 +1,220 @@
+#ifndef MULTIDATAREADER_HPP
+#define MULTIDATAREADER_HPP
+
+#include "Data.hpp"
+#include "PrefetchDataReader.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace XeThru {
+
+/**
+ * @class MultiDataReader
+ *
+ * The MultiDataReader class reads several recordings, e.g. made at the same time by
+ * different modules, as one stream of records in epoch order.
+ *
+ * Each recording (source) is read by a \ref PrefetchDataReader, so every source reads
+ * ahead on its own thread. The next record of each source is kept in a binary heap
+ * ordered by epoch, and \ref read_record returns the earliest one together with the
+ * index of its source. Records with the same epoch are returned in source order, and the
+ * records of each source keep their order in the recording.
+ *
+ * @code
+ * MultiDataReader reader;
+ * reader.set_filter(BasebandIqDataType);
+ * if (reader.open(meta_filenames) != 0)
+ *     return 1;
+ * DataRecord record;
+ * size_t source;
+ * while (reader.read_record(&record, &source) == 0)
+ *     fuse(source, record);
+ * @endcode
+ *
+ * @see DataReader, PrefetchDataReader
+ */
+class MultiDataReader
+{
+public:
+    /**
+     * Constructs reader.
+     */
+    MultiDataReader() : filter(AllDataTypes), read_ahead_records(32),
+        read_ahead_bytes(8 * 1024 * 1024), failed(false) {}
+
+    /**
+     * Opens the given recordings and starts reading them.
+     * @param meta_filenames Specifies the meta file (*xethru_recording_meta.dat*) of each source.
+     * The position of a meta file in the vector is the index of its source.
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::vector<std::string> &meta_filenames, int depth = -1)
+    {
+        close();
+        for (size_t n = 0; n < meta_filenames.size(); ++n) {
+            std::unique_ptr<Source> source(new Source);
+            source->meta_filename = meta_filenames[n];
+            source->reader.set_filter(filter);
+            source->reader.set_read_ahead(read_ahead_records, read_ahead_bytes);
+            if (source->reader.open(meta_filenames[n], depth) != 0) {
+                close();
+                return 1;
+            }
+            sources.push_back(std::move(source));
+        }
+        for (size_t n = 0; n < sources.size(); ++n) {
+            if (!refill(n)) {
+                close();
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * @return true if the recordings are successfully opened, otherwise returns false
+     */
+    bool is_open() const { return !sources.empty(); }
+
+    /**
+     * Closes all recordings.
+     */
+    void close()
+    {
+        heap.clear();
+        sources.clear();
+        failed = false;
+    }
+
+    /**
+     * @return true if no more data records is available for reading, otherwise returns false.
+     */
+    bool at_end() const { return heap.empty(); }
+
+    /**
+     * Moves the earliest record of all sources into \a record.
+     * @param[out] record Specifies the record to update.
+     * @param[out] source Specifies where to write the index of the source of the record.
+     * @return 0 on success, otherwise returns 1 (at end, or a source failed to read)
+     */
+    int read_record(DataRecord *record, size_t *source)
+    {
+        if (heap.empty())
+            return 1;
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const size_t index = heap.back().source;
+        heap.pop_back();
+        std::swap(*record, sources[index]->head);
+        *source = index;
+        if (!refill(index))
+            heap.clear();
+        return 0;
+    }
+
+    /**
+     * Sets the data types to read from every source. Takes effect on the next \ref open.
+     * @param data_types Specifies the filter as a bitmask of \ref DataType flags.
+     * @return 0 success, otherwise returns 1
+     */
+    int set_filter(uint32_t data_types)
+    {
+        filter = data_types;
+        return 0;
+    }
+
+    /**
+     * @return the filter used when reading the sources.
+     */
+    uint32_t get_filter() const { return filter; }
+
+    /**
+     * Sets how far each source reads ahead, see \ref PrefetchDataReader::set_read_ahead.
+     * Takes effect on the next \ref open.
+     */
+    void set_read_ahead(size_t record_count, size_t bytes)
+    {
+        read_ahead_records = record_count;
+        read_ahead_bytes = bytes;
+    }
+
+    /**
+     * @return true if reading a source failed. No records are returned after a failure,
+     * since the merged order can no longer be guaranteed.
+     */
+    bool has_failed() const { return failed; }
+
+    /**
+     * @return the number of sources.
+     */
+    size_t source_count() const { return sources.size(); }
+
+    /**
+     * @return the meta filename of the given source.
+     */
+    const std::string & get_meta_filename(size_t source) const { return sources[source]->meta_filename; }
+
+    /**
+     * @return the session id of the given source, see \ref DataReader::get_session_id.
+     */
+    std::string get_session_id(size_t source) const { return sources[source]->reader.get_session_id(); }
+
+    /**
+     * @return the start epoch of the given source, see \ref DataReader::get_start_epoch.
+     */
+    int64_t get_start_epoch(size_t source) const { return sources[source]->reader.get_start_epoch(); }
+
+private:
+    MultiDataReader(const MultiDataReader &other) = delete;
+    MultiDataReader& operator= (const MultiDataReader &other) = delete;
+
+    struct Source
+    {
+        std::string meta_filename;
+        PrefetchDataReader reader;
+        DataRecord head;
+    };
+
+    struct HeapEntry
+    {
+        int64_t epoch;
+        size_t source;
+    };
+
+    // Orders the heap with the earliest record, then the lowest source, on top.
+    static bool later(const HeapEntry &a, const HeapEntry &b)
+    {
+        return a.epoch != b.epoch ? a.epoch > b.epoch : a.source > b.source;
+    }
+
+    // Reads the next record of a source into the heap. Returns false if the source failed.
+    bool refill(size_t index)
+    {
+        Source &source = *sources[index];
+        if (source.reader.read_record(&source.head) != 0) {
+            failed = failed || source.reader.has_failed();
+            return !failed;
+        }
+        HeapEntry entry;
+        entry.epoch = source.head.epoch;
+        entry.source = index;
+        heap.push_back(entry);
+        std::push_heap(heap.begin(), heap.end(), later);
+        return true;
+    }
+
+    std::vector<std::unique_ptr<Source> > sources;
+    std::vector<HeapEntry> heap;
+    uint32_t filter;
+    size_t read_ahead_records;
+    size_t read_ahead_bytes;
+    bool failed;
+};
+
+} // namespace XeThru
+
+#endif // MULTIDATAREADER_HPP
@@ -0,0 +1,361 @@
+#ifndef SEGMENTEDDATAREADER_HPP
+#define SEGMENTEDDATAREADER_HPP
+
+#include "Data.hpp"
+#include "DataReader.hpp"
+#include "RangeDataReader.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace XeThru {
+
+/**
+ * @class SegmentedDataReader
+ *
+ * The SegmentedDataReader class reads the segments of a split recording in parallel.
+ *
+ * A recording made with \ref RecordingOptions::set_file_split_size or
+ * \ref RecordingOptions::set_directory_split_size consists of several segments, each
+ * with its own meta file. \ref DataReader reads them one after another on the calling
+ * thread. SegmentedDataReader opens every segment with its own \ref DataReader and reads
+ * them on a pool of worker threads, so a full pass over a long recording scales with the
+ * number of cores.
+ *
+ * With \ref EpochOrder, segments are sorted by start epoch and delivered one after another,
+ * which is global epoch order since the segments of a recording do not overlap in time;
+ * meanwhile the workers read ahead into the following segments, up to a total of
+ * \ref set_read_ahead bytes. With \ref AnyOrder, records are delivered from whichever
+ * segment has records ready, keeping the records of each segment in order.
+ *
+ * With \ref set_predicate, segments whose time span lies outside the epoch range are not
+ * read at all, and the others start reading at the beginning of the range.
+ *
+ * @code
+ * SegmentedDataReader reader;
+ * reader.set_filter(SleepDataType);
+ * if (reader.open(segment_meta_filenames) != 0)
+ *     return 1;
+ * DataRecord record;
+ * while (reader.read_record(&record) == 0)
+ *     process(record);
+ * @endcode
+ *
+ * @see DataReader
+ */
+class SegmentedDataReader
+{
+public:
+    /**
+     * Order in which records are delivered.
+     */
+    enum Order
+    {
+        EpochOrder, ///< Segments in order of start epoch, each segment in order.
+        AnyOrder    ///< Records as soon as any segment has them, each segment in order.
+    };
+
+    /**
+     * Constructs reader.
+     */
+    SegmentedDataReader() : filter(AllDataTypes), read_filter(AllDataTypes),
+        read_ahead(64 * 1024 * 1024), queued_bytes(0), order(EpochOrder), current(0),
+        next_segment(0), stopping(false), failed(false), is_opened(false) {}
+
+    /**
+     * Destroys the reader, stopping the worker threads.
+     */
+    ~SegmentedDataReader() { close(); }
+
+    /**
+     * Opens the given segments and starts reading them.
+     *
+     * @param meta_filenames Specifies the meta file (*xethru_recording_meta.dat*) of each segment.
+     * @param threads Specifies the number of worker threads. 0 uses one per core.
+     * @param read_order Specifies the order in which records are delivered.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::vector<std::string> &meta_filenames, unsigned int threads = 0,
+             Order read_order = EpochOrder)
+    {
+        close();
+        std::vector<std::pair<int64_t, std::string> > starts;
+        for (size_t n = 0; n < meta_filenames.size(); ++n) {
+            DataReader reader;
+            if (reader.open(meta_filenames[n], 1) != 0)
+                return 1;
+            const int64_t start_epoch = reader.get_start_epoch();
+            if (start_epoch >= predicate.end_epoch ||
+                start_epoch + reader.get_duration() < predicate.begin_epoch)
+                continue;
+            starts.push_back(std::make_pair(start_epoch, meta_filenames[n]));
+        }
+        if (read_order == EpochOrder)
+            std::stable_sort(starts.begin(), starts.end(),
+                [](const std::pair<int64_t, std::string> &a, const std::pair<int64_t, std::string> &b) {
+                    return a.first < b.first;
+                });
+
+        segments.resize(starts.size());
+        for (size_t n = 0; n < starts.size(); ++n) {
+            segments[n].reset(new Segment);
+            segments[n]->meta_filename = starts[n].second;
+            segments[n]->start_epoch = starts[n].first;
+        }
+        order = read_order;
+        read_filter = filter;
+        read_predicate = predicate;
+        read_predicate.data_types = filter;
+        queued_bytes = 0;
+        current = 0;
+        next_segment = 0;
+        stopping = false;
+        failed = false;
+        is_opened = true;
+
+        if (threads == 0)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        threads = std::min<unsigned int>(threads, std::max<size_t>(segments.size(), 1));
+        for (unsigned int n = 0; n < threads; ++n)
+            workers.push_back(std::thread(&SegmentedDataReader::run, this));
+        return 0;
+    }
+
+    /**
+     * @return true if the segments are successfully opened, otherwise returns false
+     */
+    bool is_open() const { return is_opened; }
+
+    /**
+     * Stops the worker threads and discards queued records.
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        space_ready.notify_all();
+        for (size_t n = 0; n < workers.size(); ++n)
+            workers[n].join();
+        workers.clear();
+        segments.clear();
+        is_opened = false;
+    }
+
+    /**
+     * Waits until the next record is read or all segments are done.
+     * @return true if no more data records is available for reading, otherwise returns false.
+     */
+    bool at_end()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return wait_for_record(lock) == nullptr;
+    }
+
+    /**
+     * Moves the next record into \a record, waiting for it to be read if necessary.
+     * @param[out] record Specifies the record to update.
+     * @return 0 on success, otherwise returns 1 (at end, or a segment failed to read)
+     */
+    int read_record(DataRecord *record)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        Segment *segment = wait_for_record(lock);
+        if (!segment)
+            return 1;
+        std::swap(*record, segment->records.front());
+        segment->records.pop_front();
+        queued_bytes -= record->data.size();
+        lock.unlock();
+        space_ready.notify_all();
+        return 0;
+    }
+
+    /**
+     * Sets the data types to read. Takes effect on the next \ref open.
+     * @param data_types Specifies the filter as a bitmask of \ref DataType flags.
+     * @return 0 success, otherwise returns 1
+     */
+    int set_filter(uint32_t data_types)
+    {
+        filter = data_types;
+        return 0;
+    }
+
+    /**
+     * @return the filter used when reading the segments.
+     */
+    uint32_t get_filter() const { return filter; }
+
+    /**
+     * Sets the epoch and frame counter ranges to read. Takes effect on the next \ref open.
+     * The data types are set with \ref set_filter; RecordPredicate::data_types is ignored.
+     * @param record_predicate Specifies the records to read.
+     */
+    void set_predicate(const RecordPredicate &record_predicate)
+    {
+        predicate = record_predicate;
+    }
+
+    /**
+     * @return the predicate used when reading the segments.
+     */
+    const RecordPredicate & get_predicate() const { return predicate; }
+
+    /**
+     * Sets how many bytes of records may be queued ahead of the reader, 64 MiB by default.
+     * The segment being delivered always reads ahead at least one record.
+     * @param bytes Specifies the number of bytes.
+     */
+    void set_read_ahead(size_t bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        read_ahead = bytes;
+    }
+
+    /**
+     * @return true if reading a segment failed. Records after the failure are not delivered.
+     */
+    bool has_failed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    /**
+     * @return the number of segments read, i.e. not skipped by the predicate.
+     */
+    size_t segment_count() const { return segments.size(); }
+
+private:
+    SegmentedDataReader(const SegmentedDataReader &other) = delete;
+    SegmentedDataReader& operator= (const SegmentedDataReader &other) = delete;
+
+    struct Segment
+    {
+        Segment() : start_epoch(0), done(false) {}
+        std::string meta_filename;
+        int64_t start_epoch;
+        std::deque<DataRecord> records;
+        bool done;
+    };
+
+    // Returns a segment with a record ready, or nullptr when all records are delivered.
+    Segment * wait_for_record(std::unique_lock<std::mutex> &lock)
+    {
+        for (;;) {
+            if (failed || stopping)
+                return nullptr;
+            if (order == EpochOrder) {
+                bool advanced = false;
+                while (current < segments.size() && segments[current]->done && segments[current]->records.empty()) {
+                    ++current;
+                    advanced = true;
+                }
+                if (advanced)
+                    space_ready.notify_all();
+                if (current == segments.size())
+                    return nullptr;
+                if (!segments[current]->records.empty())
+                    return segments[current].get();
+            } else {
+                bool all_done = true;
+                for (size_t n = 0; n < segments.size(); ++n) {
+                    const size_t index = (current + n) % segments.size();
+                    Segment &segment = *segments[index];
+                    if (!segment.records.empty()) {
+                        current = index;
+                        return &segment;
+                    }
+                    all_done = all_done && segment.done;
+                }
+                if (all_done)
+                    return nullptr;
+            }
+            data_ready.wait(lock);
+        }
+    }
+
+    void run()
+    {
+        for (;;) {
+            size_t index;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (stopping || next_segment == segments.size())
+                    return;
+                index = next_segment++;
+            }
+            const bool ok = read_segment(index);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                segments[index]->done = true;
+                failed = failed || !ok;
+            }
+            data_ready.notify_all();
+        }
+    }
+
+    bool read_segment(size_t index)
+    {
+        Segment &segment = *segments[index];
+        DataReader reader;
+        if (reader.open(segment.meta_filename, 1) != 0 || reader.set_filter(read_filter) != 0)
+            return false;
+        if (read_predicate.begin_epoch > segment.start_epoch &&
+            reader.seek_ms(read_predicate.begin_epoch - segment.start_epoch) != 0)
+            return false;
+        while (!reader.at_end()) {
+            DataRecord record = reader.read_record();
+            if (!record.is_valid)
+                return false;
+            if (read_predicate.is_past_end(record.data_type, record.epoch, record.data.data(),
+                                           static_cast<uint32_t>(record.data.size()), record.is_user_header))
+                break;
+            if (!read_predicate.matches(record))
+                continue;
+            std::unique_lock<std::mutex> lock(mutex);
+            space_ready.wait(lock, [this, &segment, index]() {
+                return stopping || queued_bytes < read_ahead ||
+                    (order == EpochOrder ? index == current : segment.records.empty());
+            });
+            if (stopping)
+                return true;
+            queued_bytes += record.data.size();
+            segment.records.push_back(std::move(record));
+            lock.unlock();
+            data_ready.notify_one();
+        }
+        return true;
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable data_ready;
+    std::condition_variable space_ready;
+    std::vector<std::unique_ptr<Segment> > segments;
+    std::vector<std::thread> workers;
+    uint32_t filter;
+    uint32_t read_filter;
+    RecordPredicate predicate;
+    RecordPredicate read_predicate;
+    size_t read_ahead;
+    size_t queued_bytes;
+    Order order;
+    size_t current;
+    size_t next_segment;
+    bool stopping;
+    bool failed;
+    bool is_opened;
+};
+
+} // namespace XeThru
+
+#endif // SEGMENTEDDATAREADER_HPP
@@ -0,0 +1,355 @@
+#ifndef TRIGGEREDDATARECORDER_HPP
+#define TRIGGEREDDATARECORDER_HPP
+
+#include "Bytes.hpp"
+#include "Data.hpp"
+#include "DataRecorder.hpp"
+#include "RecordDecoder.hpp"
+#include "RecordingOptions.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace XeThru {
+
+/**
+ * @class TriggeredDataRecorder
+ *
+ * The TriggeredDataRecorder class records only the data around events, like a flight
+ * recorder.
+ *
+ * Data passed to \ref process is kept in an in-memory ring holding the last
+ * \a pre_trigger_ms milliseconds. When \ref trigger is called, or a trigger predicate
+ * accepts an incoming \ref PresenceSingleData or \ref SleepData, the recorder starts a
+ * recording session, writes the ring to it and keeps recording for \a post_trigger_ms
+ * milliseconds. A trigger during the post-trigger window extends the window. Each
+ * triggered window is a normal recording, readable with \ref DataReader.
+ *
+ * The ring is allocated up front for the records of the pre-trigger window, from the
+ * record rate and the largest record size given to the constructor, and is allocated again
+ * by \ref set_windows and \ref set_record_rate. Keeping a record then copies it into the
+ * buffer of a slot without allocating, unless the record is larger than the given size.
+ * If the data arrives faster than the given rate, the oldest records are dropped, see
+ * \ref get_dropped_count.
+ *
+ * The class only sees the data passed to its \ref process, which it forwards to
+ * \ref DataRecorder::process, the entry point for data generated by the application. The
+ * library records the data of a module on its own thread, which this class cannot reach,
+ * so the data of a module is only kept when the application passes it on as records,
+ * with the layout of a recorded record of its type, as \ref DataReader returns it.
+ *
+ * There is no timer thread: a session ends at the first call to \ref process or
+ * \ref trigger after its post-trigger window, and a trigger after the window starts a new
+ * session.
+ *
+ * The trigger predicates decode the data as recorded, i.e. \ref PresenceSingleDataType and
+ * \ref SleepDataType records are CSV rows as returned by \ref DataReader and decoded by
+ * \ref decode_record. Data in any other format, e.g. binary packets from a module, never
+ * triggers; evaluate the condition on the decoded module messages and call \ref trigger
+ * instead.
+ *
+ * @note \ref DataRecorder stamps records with the time they are written, so the records
+ * of the pre-trigger window carry the time of the trigger.
+ *
+ * @code
+ * DataRecorder recorder;
+ * // 17 baseband records per second of at most 2 KiB each.
+ * TriggeredDataRecorder flight_recorder(recorder, BasebandIqDataType, directory, 17, 2048);
+ * flight_recorder.set_windows(10000, 20000);
+ * // For every baseband record the application produces:
+ * flight_recorder.process(BasebandIqDataType, record_bytes);
+ * // When the presence message from the module reports presence:
+ * if (presence.presence_state == XTS_VAL_PRESENCE_PRESENCESTATE_PRESENCE)
+ *     flight_recorder.trigger();
+ * @endcode
+ *
+ * @see DataRecorder, AsyncDataRecorder
+ */
+class TriggeredDataRecorder
+{
+public:
+    typedef std::function<bool(const PresenceSingleData &)> PresenceTrigger;
+    typedef std::function<bool(const SleepData &)> SleepTrigger;
+
+    /**
+     * Constructs the recorder.
+     * @param data_recorder Specifies the recorder to write triggered sessions with. It must outlive this object.
+     * @param data_types Specifies the data types to keep and record.
+     * @param directory Specifies the output folder, see \ref DataRecorder::start_recording.
+     * @param records_per_second Specifies the highest rate of the records of \a data_types
+     * passed to \ref process, all types together.
+     * @param max_record_size Specifies the size in bytes of the largest record.
+     * @param options Specifies the recording options of each triggered session.
+     */
+    TriggeredDataRecorder(DataRecorder &data_recorder, DataTypes data_types, const std::string &directory,
+                          double records_per_second, size_t max_record_size,
+                          const RecordingOptions &options = RecordingOptions()) :
+        recorder(data_recorder),
+        recorded_types(data_types),
+        output_directory(directory),
+        recording_options(options),
+        pre_trigger_ms(10000),
+        post_trigger_ms(10000),
+        record_rate(records_per_second),
+        record_size(max_record_size),
+        head(0),
+        count(0),
+        dropped(0),
+        sessions(0),
+        recording(false),
+        deadline(0)
+    {
+        allocate();
+    }
+
+    /**
+     * Stops a triggered session in progress.
+     */
+    ~TriggeredDataRecorder()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (recording)
+            recorder.stop_recording(recorded_types);
+    }
+
+    /**
+     * Sets the length of the windows before and after a trigger, and allocates the ring
+     * for the pre-trigger window, discarding the data it holds. By default, both windows
+     * are 10000 milliseconds.
+     * @param pre_trigger Specifies the milliseconds of data kept before a trigger.
+     * @param post_trigger Specifies the milliseconds of data recorded after the last trigger.
+     */
+    void set_windows(int64_t pre_trigger, int64_t post_trigger)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pre_trigger_ms = std::max<int64_t>(pre_trigger, 0);
+        post_trigger_ms = post_trigger;
+        allocate();
+    }
+
+    /**
+     * Sets the record rate and size the ring is allocated for, and allocates it, discarding
+     * the data it holds.
+     * @param records_per_second Specifies the highest rate of the records passed to \ref process.
+     * @param max_record_size Specifies the size in bytes of the largest record.
+     */
+    void set_record_rate(double records_per_second, size_t max_record_size)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        record_rate = records_per_second;
+        record_size = max_record_size;
+        allocate();
+    }
+
+    /**
+     * @return the number of records the ring holds.
+     */
+    size_t get_capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return ring.size();
+    }
+
+    /**
+     * Sets a predicate triggering the recorder when it returns true for an incoming
+     * \ref PresenceSingleDataType record, a CSV row as recorded. Pass nullptr to clear it.
+     */
+    void set_presence_trigger(const PresenceTrigger &predicate)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        presence_trigger = predicate;
+    }
+
+    /**
+     * Sets a predicate triggering the recorder when it returns true for an incoming
+     * \ref SleepDataType record, a CSV row as recorded. Pass nullptr to clear it.
+     */
+    void set_sleep_trigger(const SleepTrigger &predicate)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sleep_trigger = predicate;
+    }
+
+    /**
+     * Keeps or records the data, and evaluates the trigger predicates on it.
+     * @param data_type Specifies the data type to process
+     * @param data Specifies the bytes to process
+     * @return true on success, otherwise returns false
+     */
+    bool process(DataType data_type, const Bytes &data)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const int64_t now = now_ms();
+        expire(now);
+        bool ok = true;
+        if (data_type & recorded_types) {
+            if (recording)
+                ok = recorder.process(data_type, data);
+            else
+                keep(now, data_type, data);
+        }
+        if (is_trigger(data_type, data))
+            ok = start(now) && ok;
+        return ok;
+    }
+
+    /**
+     * Starts recording the pre-trigger window and the following post-trigger window, or
+     * extends the post-trigger window of the session in progress.
+     * @return 0 on success, otherwise returns 1
+     */
+    int trigger()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const int64_t now = now_ms();
+        expire(now);
+        return start(now) ? 0 : 1;
+    }
+
+    /**
+     * @return true while a triggered session is being recorded.
+     */
+    bool is_recording() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return recording;
+    }
+
+    /**
+     * @return the number of sessions started by triggers.
+     */
+    uint64_t get_session_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return sessions;
+    }
+
+    /**
+     * @return the number of records dropped from the pre-trigger window because the ring was
+     * full, i.e. the data arrived faster than the record rate given.
+     */
+    uint64_t get_dropped_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dropped;
+    }
+
+private:
+    TriggeredDataRecorder(const TriggeredDataRecorder &other) = delete;
+    TriggeredDataRecorder& operator= (const TriggeredDataRecorder &other) = delete;
+
+    struct Slot
+    {
+        Slot() : time(0), data_type(InvalidDataType) {}
+        int64_t time;
+        uint32_t data_type;
+        Bytes data;
+    };
+
+    static int64_t now_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Allocates the ring for the records of the pre-trigger window, with one slot to spare
+    // for the record arriving as the oldest one expires.
+    void allocate()
+    {
+        const double records = record_rate > 0 ? std::ceil(record_rate * pre_trigger_ms / 1000.0) : 0;
+        std::vector<Slot>(static_cast<size_t>(records) + 1).swap(ring);
+        for (size_t n = 0; n < ring.size(); ++n)
+            ring[n].data.reserve(record_size);
+        head = 0;
+        count = 0;
+    }
+
+    // Stores the data in the ring, reusing the buffer of the slot.
+    void keep(int64_t now, DataType data_type, const Bytes &data)
+    {
+        while (count > 0 && ring[head].time < now - pre_trigger_ms) {
+            head = (head + 1) % ring.size();
+            --count;
+        }
+        if (count == ring.size()) {
+            head = (head + 1) % ring.size();
+            --count;
+            ++dropped;
+        }
+        Slot &slot = ring[(head + count) % ring.size()];
+        slot.time = now;
+        slot.data_type = data_type;
+        slot.data.assign(data.begin(), data.end());
+        ++count;
+    }
+
+    // Ends the session once its post-trigger window has passed.
+    void expire(int64_t now)
+    {
+        if (recording && now >= deadline) {
+            recorder.stop_recording(recorded_types);
+            recording = false;
+        }
+    }
+
+    // The sensor data types are recorded as CSV rows, which decode_record parses.
+    bool is_trigger(DataType data_type, const Bytes &data)
+    {
+        if (data_type == PresenceSingleDataType && presence_trigger)
+            return decode_record(data.data(), static_cast<uint32_t>(data.size()), &presence) == 0 &&
+                presence_trigger(presence);
+        if (data_type == SleepDataType && sleep_trigger)
+            return decode_record(data.data(), static_cast<uint32_t>(data.size()), &sleep) == 0 &&
+                sleep_trigger(sleep);
+        return false;
+    }
+
+    bool start(int64_t now)
+    {
+        deadline = now + post_trigger_ms;
+        if (recording)
+            return true;
+        if (recorder.start_recording(recorded_types, output_directory, recording_options) != 0)
+            return false;
+        recording = true;
+        ++sessions;
+        bool ok = true;
+        for (; count > 0; --count) {
+            const Slot &slot = ring[head];
+            ok = recorder.process(static_cast<DataType>(slot.data_type), slot.data) && ok;
+            head = (head + 1) % ring.size();
+        }
+        return ok;
+    }
+
+    DataRecorder &recorder;
+    const DataTypes recorded_types;
+    const std::string output_directory;
+    const RecordingOptions recording_options;
+    mutable std::mutex mutex;
+    int64_t pre_trigger_ms;
+    int64_t post_trigger_ms;
+    double record_rate;
+    size_t record_size;
+    std::vector<Slot> ring;
+    size_t head;
+    size_t count;
+    uint64_t dropped;
+    uint64_t sessions;
+    bool recording;
+    int64_t deadline;
+    PresenceTrigger presence_trigger;
+    SleepTrigger sleep_trigger;
+    PresenceSingleData presence;
+    SleepData sleep;
+};
+
+} // namespace XeThru
+
+#endif // TRIGGEREDDATARECORDER_HPP
@@ -5,7 +5,9 @@
 #include "Data.hpp"
 #include "Bytes.hpp"
 #include "LockedRadarForward.hpp"
+#include "MessageWait.hpp"
 
+#include <chrono>
 #include <cinttypes>
 #include <string>
 #include <vector>
@@ -404,6 +406,50 @@ public:
      */
     int read_message_noisemap_byte(PulseDopplerByteData *data);
 
+    /**
+     * Returns which of the given data types have messages queued.
+     *
+     * @param data_types: bitmask of DataType flags to check. Supported flags are
+     * PresenceSingleDataType, PresenceMovingListDataType, BasebandApDataType, BasebandIqDataType, PulseDopplerFloatDataType, PulseDopplerByteDataType, NoiseMapFloatDataType, NoiseMapByteDataType.
+     * @return the subset of data_types with at least one queued message
+     */
+    DataTypes queued_message_types(DataTypes data_types)
+    {
+        DataTypes ready = 0;
+        if ((data_types & PresenceSingleDataType) && peek_message_presence_single() > 0)
+            ready |= PresenceSingleDataType;
+        if ((data_types & PresenceMovingListDataType) && peek_message_presence_movinglist() > 0)
+            ready |= PresenceMovingListDataType;
+        if ((data_types & BasebandApDataType) && peek_message_baseband_ap() > 0)
+            ready |= BasebandApDataType;
+        if ((data_types & BasebandIqDataType) && peek_message_baseband_iq() > 0)
+            ready |= BasebandIqDataType;
+        if ((data_types & PulseDopplerFloatDataType) && peek_message_pulsedoppler_float() > 0)
+            ready |= PulseDopplerFloatDataType;
+        if ((data_types & PulseDopplerByteDataType) && peek_message_pulsedoppler_byte() > 0)
+            ready |= PulseDopplerByteDataType;
+        if ((data_types & NoiseMapFloatDataType) && peek_message_noisemap_float() > 0)
+            ready |= NoiseMapFloatDataType;
+        if ((data_types & NoiseMapByteDataType) && peek_message_noisemap_byte() > 0)
+            ready |= NoiseMapByteDataType;
+        return ready;
+    }
+
+    /**
+     * Waits until a message of one of the given data types is queued, or the timeout expires.
+     * Use this instead of polling the peek_message_* functions in a loop.
+     *
+     * @param data_types: bitmask of DataType flags to wait for, for example
+     * PresenceSingleDataType | BasebandIqDataType. See \ref queued_message_types for supported flags.
+     * @param timeout: maximum time to wait
+     * @return the subset of data_types with queued messages, or 0 on timeout
+     */
+    DataTypes wait_for_message(DataTypes data_types, std::chrono::microseconds timeout)
+    {
+        return wait_for_ready_types([this, data_types]() { return queued_message_types(data_types); },
+                                    timeout);
+    }
+
     /**
      * Send command to module to load a previously stored noisemap
      *
@@ -0,0 +1,104 @@
+#include "DataReader.hpp"
+#include "RadarFrameCodec.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+/** \example compress_recording.cpp
+ * this is a small example converting a recording to a compressed recording file and
+ * verifying it against the recording in a second pass, reporting the compression ratio
+ * and codec speed
+ */
+
+using namespace XeThru;
+
+int compress_recording(const std::string &meta_filename, const std::string &output_filename)
+{
+    DataReader reader;
+    if (reader.open(meta_filename) != 0) {
+        std::cout << "ERROR: failed to open recording" << std::endl;
+        return 1;
+    }
+
+    // First pass: compress the records as they are read.
+    CompressedDataWriter writer;
+    if (writer.open(output_filename) != 0) {
+        std::cout << "ERROR: failed to create " << output_filename << std::endl;
+        return 1;
+    }
+    DataRecord record;
+    size_t count = 0;
+    std::chrono::steady_clock::duration encode_time(0);
+    while (!reader.at_end()) {
+        record = reader.read_record();
+        if (!record.is_valid) {
+            std::cout << "ERROR: failed to read record" << std::endl;
+            return 1;
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const int status = writer.write_record(record);
+        encode_time += std::chrono::steady_clock::now() - start;
+        if (status != 0) {
+            std::cout << "ERROR: failed to write record" << std::endl;
+            return 1;
+        }
+        ++count;
+    }
+    if (writer.close() != 0) {
+        std::cout << "ERROR: failed to write " << output_filename << std::endl;
+        return 1;
+    }
+
+    // Second pass: read the recording again and compare it with the decoded records.
+    CompressedDataReader compressed_reader;
+    if (compressed_reader.open(output_filename) != 0 || reader.seek_byte(0) != 0) {
+        std::cout << "ERROR: failed to open " << output_filename << std::endl;
+        return 1;
+    }
+    DataRecord decoded;
+    size_t checked = 0;
+    std::chrono::steady_clock::duration decode_time(0);
+    while (!reader.at_end()) {
+        record = reader.read_record();
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const int status = compressed_reader.read_record(&decoded);
+        decode_time += std::chrono::steady_clock::now() - start;
+        if (!record.is_valid || status != 0) {
+            std::cout << "ERROR: read " << checked << " of " << count << " records" << std::endl;
+            return 1;
+        }
+        if (decoded.data != record.data || decoded.data_type != record.data_type ||
+            decoded.epoch != record.epoch || decoded.is_user_header != record.is_user_header) {
+            std::cout << "ERROR: record " << checked << " differs after decoding" << std::endl;
+            return 1;
+        }
+        ++checked;
+    }
+    if (checked != count || !compressed_reader.at_end() || compressed_reader.has_failed()) {
+        std::cout << "ERROR: " << output_filename << " holds a different number of records" << std::endl;
+        return 1;
+    }
+
+    const double encode_seconds = std::chrono::duration<double>(encode_time).count();
+    const double decode_seconds = std::chrono::duration<double>(decode_time).count();
+    const double duration_seconds = reader.get_duration() / 1000.0;
+    std::cout << count << " records, " << writer.get_record_bytes() << " bytes compressed to "
+              << writer.get_file_bytes() << " bytes, ratio " << writer.get_compression_ratio() << std::endl;
+    std::cout << "encode " << encode_seconds << " s, decode " << decode_seconds << " s";
+    if (duration_seconds > 0)
+        std::cout << " for " << duration_seconds << " s of data ("
+                  << duration_seconds / std::max(encode_seconds, decode_seconds) << "x real time)";
+    std::cout << std::endl;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::cout << "compress_recording <xethru recording meta file> <output file>" << std::endl;
+        return 1;
+    }
+
+    return compress_recording(argv[1], argv[2]);
+}
@@ -0,0 +1,300 @@
+#ifndef ASYNCDATARECORDER_HPP
+#define ASYNCDATARECORDER_HPP
+
+#include "Bytes.hpp"
+#include "DataRecorder.hpp"
+#include "datatypes.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace XeThru {
+
+/**
+ * @class AsyncDataRecorder
+ *
+ * The AsyncDataRecorder class moves the disk writes of \ref DataRecorder::process to a
+ * writer thread.
+ *
+ * \ref DataRecorder::process writes to disk on the calling thread, so with
+ * \ref RecordingOptions::set_flush_on_write a slow disk stalls the thread receiving radar
+ * data. AsyncDataRecorder::process only copies the data into a bounded ring and returns;
+ * a writer thread drains the ring in batches and passes the records to the recorder in
+ * the order they were queued.
+ *
+ * The ring is lock-free and may be filled from several threads. Each slot keeps its
+ * buffer, so once the slots have grown to the largest record, queueing does not allocate.
+ * When the ring is full, process drops the record and counts it instead of waiting, see
+ * \ref get_dropped_count.
+ *
+ * @code
+ * DataRecorder recorder;
+ * recorder.start_recording(BasebandIqDataType, directory, options);
+ * AsyncDataRecorder async_recorder(recorder, 4096);
+ * // On the receive thread:
+ * async_recorder.process(BasebandIqDataType, bytes);
+ * // When done:
+ * async_recorder.flush();
+ * recorder.stop_recording(AllDataTypes);
+ * @endcode
+ *
+ * @see DataRecorder
+ */
+class AsyncDataRecorder
+{
+public:
+    /**
+     * Constructs the recorder and starts the writer thread.
+     * @param data_recorder Specifies the recorder to write with. It must outlive this object.
+     * @param capacity Specifies the number of records the ring holds, rounded up to a power of two.
+     */
+    explicit AsyncDataRecorder(DataRecorder &data_recorder, size_t capacity = 1024) :
+        recorder(data_recorder),
+        mask(round_up_capacity(capacity) - 1),
+        slots(new Slot[mask + 1]),
+        enqueue_pos(0),
+        dequeue_pos(0),
+        dropped(0),
+        failed(0),
+        max_depth(0),
+        stopping(false),
+        writer_waiting(false)
+    {
+        for (size_t n = 0; n <= mask; ++n)
+            slots[n].sequence.store(n, std::memory_order_relaxed);
+        writer = std::thread(&AsyncDataRecorder::run, this);
+    }
+
+    /**
+     * Writes the queued records and stops the writer thread.
+     */
+    ~AsyncDataRecorder()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        data_ready.notify_one();
+        writer.join();
+    }
+
+    /**
+     * Queues the data for the writer thread. Never blocks.
+     * @param data_type Specifies the data type to process
+     * @param data Specifies the bytes to process
+     * @return true if the data was queued, false if the ring was full and the data dropped
+     */
+    bool process(DataType data_type, const Bytes &data)
+    {
+        return process(data_type, data.data(), data.size());
+    }
+
+    /**
+     * Queues the data for the writer thread. Never blocks.
+     * @param data_type Specifies the data type to process
+     * @param data Specifies the bytes to process
+     * @param size Specifies the number of bytes
+     * @return true if the data was queued, false if the ring was full and the data dropped
+     */
+    bool process(DataType data_type, const uint8_t *data, size_t size)
+    {
+        size_t pos;
+        Slot *slot = claim(&pos);
+        if (!slot)
+            return false;
+        slot->data_type = data_type;
+        slot->data.assign(data, data + size);
+        publish(slot, pos);
+        return true;
+    }
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+    /**
+     * Queues the data gathered from \a count buffers for the writer thread. Never blocks.
+     * The buffers are copied straight into the ring slot.
+     * @param data_type Specifies the data type to process
+     * @param buffers Specifies the buffers holding the bytes to process, in order
+     * @param count Specifies the number of buffers
+     * @return true if the data was queued, false if the ring was full and the data dropped
+     */
+    bool process(DataType data_type, const struct iovec *buffers, size_t count)
+    {
+        size_t pos;
+        Slot *slot = claim(&pos);
+        if (!slot)
+            return false;
+        slot->data_type = data_type;
+        slot->data.clear();
+        for (size_t n = 0; n < count; ++n) {
+            const uint8_t *data = static_cast<const uint8_t *>(buffers[n].iov_base);
+            slot->data.insert(slot->data.end(), data, data + buffers[n].iov_len);
+        }
+        publish(slot, pos);
+        return true;
+    }
+#endif // !_WIN32
+
+    /**
+     * Waits until every record queued before the call is passed to the recorder.
+     */
+    void flush()
+    {
+        const size_t target = enqueue_pos.load(std::memory_order_acquire);
+        data_ready.notify_one();
+        std::unique_lock<std::mutex> lock(mutex);
+        while (static_cast<intptr_t>(dequeue_pos.load(std::memory_order_acquire) - target) < 0)
+            drained.wait_for(lock, std::chrono::milliseconds(1));
+    }
+
+    /**
+     * @return the number of slots in the ring.
+     */
+    size_t get_capacity() const { return mask + 1; }
+
+    /**
+     * @return the number of records queued and not yet passed to the recorder.
+     */
+    size_t get_queue_depth() const
+    {
+        // Dequeue first: it never passes enqueue_pos, so the later enqueue_pos is not behind it.
+        const size_t dequeued = dequeue_pos.load(std::memory_order_acquire);
+        const size_t enqueued = enqueue_pos.load(std::memory_order_relaxed);
+        return static_cast<intptr_t>(enqueued - dequeued) > 0 ? enqueued - dequeued : 0;
+    }
+
+    /**
+     * @return the largest queue depth seen, a measure of how close the ring came to dropping records.
+     */
+    size_t get_max_queue_depth() const { return max_depth.load(std::memory_order_relaxed); }
+
+    /**
+     * @return the number of records dropped because the ring was full.
+     */
+    uint64_t get_dropped_count() const { return dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * @return the number of records the recorder failed to process, see \ref DataRecorder::process.
+     */
+    uint64_t get_failed_count() const { return failed.load(std::memory_order_relaxed); }
+
+private:
+    AsyncDataRecorder(const AsyncDataRecorder &other) = delete;
+    AsyncDataRecorder& operator= (const AsyncDataRecorder &other) = delete;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        DataType data_type;
+        Bytes data;
+    };
+
+    static size_t round_up_capacity(size_t capacity)
+    {
+        size_t result = 2;
+        while (result < capacity)
+            result <<= 1;
+        return result;
+    }
+
+    // Reserves the next slot for a producer, or returns nullptr when the ring is full.
+    Slot *claim(size_t *claimed_pos)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot *slot = &slots[pos & mask];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (difference == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *claimed_pos = pos;
+                    return slot;
+                }
+            } else if (difference < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Hands a filled slot to the writer thread.
+    void publish(Slot *slot, size_t pos)
+    {
+        // Measured before the slot is published, while the writer cannot have dequeued it.
+        const size_t dequeued = dequeue_pos.load(std::memory_order_relaxed);
+        const size_t depth = static_cast<intptr_t>(pos + 1 - dequeued) > 0 ? pos + 1 - dequeued : 0;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        size_t previous = max_depth.load(std::memory_order_relaxed);
+        while (depth > previous && !max_depth.compare_exchange_weak(previous, depth, std::memory_order_relaxed)) {}
+        if (writer_waiting.load(std::memory_order_acquire))
+            data_ready.notify_one();
+    }
+
+    // Passes the ready records to the recorder. Returns the number of records written.
+    size_t drain()
+    {
+        size_t count = 0;
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+                break;
+            if (!recorder.process(slot.data_type, slot.data))
+                failed.fetch_add(1, std::memory_order_relaxed);
+            slot.sequence.store(pos + mask + 1, std::memory_order_release);
+            dequeue_pos.store(++pos, std::memory_order_release);
+            ++count;
+        }
+        return count;
+    }
+
+    void run()
+    {
+        for (;;) {
+            const size_t count = drain();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (count > 0) {
+                drained.notify_all();
+                continue;
+            }
+            if (stopping) {
+                lock.unlock();
+                // Records queued before the destructor was called.
+                drain();
+                drained.notify_all();
+                return;
+            }
+            // process does not take the mutex, so a wakeup may be missed; the timeout
+            // bounds the delay.
+            writer_waiting.store(true, std::memory_order_release);
+            data_ready.wait_for(lock, std::chrono::milliseconds(1));
+            writer_waiting.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    DataRecorder &recorder;
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> enqueue_pos;
+    std::atomic<size_t> dequeue_pos;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint64_t> failed;
+    std::atomic<size_t> max_depth;
+    std::mutex mutex;
+    std::condition_variable data_ready;
+    std::condition_variable drained;
+    bool stopping;
+    std::atomic<bool> writer_waiting;
+    std::thread writer;
+};
+
+} // namespace XeThru
+
+#endif // ASYNCDATARECORDER_HPP
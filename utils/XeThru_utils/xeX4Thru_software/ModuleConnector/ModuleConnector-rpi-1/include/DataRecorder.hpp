@@ -6,6 +6,12 @@
 #include "RecordingOptions.hpp"
 #include "LockedRadarForward.hpp"
 
+#include <cstring>
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+#include <sys/uio.h>
+#endif // !_WIN32
+
 struct Logger;
 
 namespace XeThru {
@@ -152,6 +158,56 @@ public:
      */
     bool process(XeThru::DataType data_type, const Bytes &data);
 
+    /**
+     * Process the specified data for a given data type, see \ref process(XeThru::DataType, const Bytes &).
+     *
+     * The data is copied once into a buffer kept per thread, so callers holding raw packet
+     * memory do not allocate a \ref Bytes for every record.
+     *
+     * @param data_type Specifies the data type to process
+     * @param data Specifies the bytes to process
+     * @param size Specifies the number of bytes
+     *
+     * @return true on success, otherwise returns false
+     */
+    inline bool process(XeThru::DataType data_type, const uint8_t *data, size_t size)
+    {
+        Bytes &buffer = process_buffer();
+        buffer.resize(size);
+        if (size > 0)
+            std::memcpy(buffer.data(), data, size);
+        return process(data_type, buffer);
+    }
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+    /**
+     * Process the data gathered from \a count buffers for a given data type, see
+     * \ref process(XeThru::DataType, const Bytes &). Useful when the record header and the
+     * payload are held in separate buffers.
+     *
+     * @param data_type Specifies the data type to process
+     * @param buffers Specifies the buffers holding the bytes to process, in order
+     * @param count Specifies the number of buffers
+     *
+     * @return true on success, otherwise returns false
+     */
+    inline bool process(XeThru::DataType data_type, const struct iovec *buffers, size_t count)
+    {
+        size_t size = 0;
+        for (size_t n = 0; n < count; ++n)
+            size += buffers[n].iov_len;
+        Bytes &buffer = process_buffer();
+        buffer.resize(size);
+        size_t offset = 0;
+        for (size_t n = 0; n < count; ++n) {
+            if (buffers[n].iov_len > 0)
+                std::memcpy(buffer.data() + offset, buffers[n].iov_base, buffers[n].iov_len);
+            offset += buffers[n].iov_len;
+        }
+        return process(data_type, buffer);
+    }
+#endif // !_WIN32
+
     /**
      * Subscribes to notifications when a recorded file for a data type is available. The callback is
      * triggered when a new file is stored on disk, i.e. when module connector is done with the file
@@ -282,6 +338,14 @@ private:
     DataRecorder& operator= (const DataRecorder &other) = delete;
     DataRecorder& operator= (DataRecorder &&other) = delete;
 
+    // Reused by the pointer overloads of process. The library only takes Bytes, and a buffer
+    // per thread keeps its capacity across records without a data member in this class.
+    static Bytes &process_buffer()
+    {
+        static thread_local Bytes buffer;
+        return buffer;
+    }
+
     friend RadarInterface;
     DataRecorderPrivate *d_ptr;
 };
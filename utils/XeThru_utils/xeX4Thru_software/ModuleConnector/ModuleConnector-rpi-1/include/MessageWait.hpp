@@ -0,0 +1,55 @@
+#ifndef MESSAGEWAIT_HPP
+#define MESSAGEWAIT_HPP
+
+#include "datatypes.h"
+
+#include <chrono>
+#include <thread>
+
+namespace XeThru {
+
+/**
+ * Waits until \a ready_types returns a non-zero \ref DataTypes mask or \a timeout expires.
+ *
+ * Used by the wait_for_message functions of the module interfaces. The queues are polled
+ * with a short back-off instead of a fixed sleep: the first polls only yield the thread,
+ * after which the wait between polls doubles up to 250 microseconds. A message that
+ * arrives while the caller waits is therefore seen well within a millisecond, and a
+ * caller waiting on an idle module does not keep a core busy.
+ *
+ * @param ready_types Callable returning the mask of data types with queued messages.
+ * @param timeout Specifies how long to wait. Zero checks once without waiting.
+ * @return the mask returned by \a ready_types, or 0 on timeout.
+ */
+template<typename ReadyTypes>
+DataTypes wait_for_ready_types(ReadyTypes ready_types, std::chrono::microseconds timeout)
+{
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + timeout;
+    const std::chrono::microseconds max_backoff(250);
+    std::chrono::microseconds backoff(0);
+    int yields = 0;
+
+    for (;;) {
+        const DataTypes ready = ready_types();
+        if (ready)
+            return ready;
+        const Clock::time_point now = Clock::now();
+        if (now >= deadline)
+            return 0;
+        if (yields < 16) {
+            ++yields;
+            std::this_thread::yield();
+            continue;
+        }
+        backoff = backoff.count() == 0 ? std::chrono::microseconds(10) : backoff * 2;
+        if (backoff > max_backoff)
+            backoff = max_backoff;
+        const Clock::duration left = deadline - now;
+        std::this_thread::sleep_for(left < backoff ? left : Clock::duration(backoff));
+    }
+}
+
+} // namespace XeThru
+
+#endif // MESSAGEWAIT_HPP
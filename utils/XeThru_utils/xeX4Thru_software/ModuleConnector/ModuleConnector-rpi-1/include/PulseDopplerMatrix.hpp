@@ -0,0 +1,321 @@
+#ifndef PULSEDOPPLERMATRIX_HPP
+#define PULSEDOPPLERMATRIX_HPP
+
+#include "Data.hpp"
+#include "RadarKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace XeThru {
+
+/**
+ * @class PulseDopplerMatrix
+ *
+ * One complete range-Doppler matrix assembled by \ref PulseDopplerMatrixAssembler.
+ *
+ * The matrix is stored row major with range_bins rows of frequency_bins values. The
+ * frequency axis spans the negative and the positive half sent by the module, from
+ * frequency_start in steps of frequency_step. Byte data is stored as linear values,
+ * i.e. the same unit as \ref PulseDopplerFloatData.
+ */
+class PulseDopplerMatrix
+{
+public:
+    PulseDopplerMatrix():
+        frame_counter(0), matrix_counter(0), pulsedoppler_instance(0),
+        range_bins(0), frequency_bins(0), fps(0), fps_decimated(0),
+        frequency_start(0), frequency_step(0), missing_rows(0)
+    {}
+
+    /**
+     * Returns a pointer to the frequency_bins values of the given range bin.
+     */
+    const float * row(uint32_t range_idx) const { return data.data() + range_idx * frequency_bins; }
+
+    /**
+     * Returns the value at the given range bin and frequency bin.
+     */
+    float at(uint32_t range_idx, uint32_t frequency_idx) const { return row(range_idx)[frequency_idx]; }
+
+    /**
+     * Frame counter of the last row received
+     */
+    uint32_t frame_counter;
+
+    /**
+     * Incremental matrix counter.
+     */
+    uint32_t matrix_counter;
+
+    /**
+     * Selected pulse-Doppler type from [0..N-1] where N is number of PDs.
+     */
+    uint32_t pulsedoppler_instance;
+
+    /**
+     * Number of rows
+     */
+    uint32_t range_bins;
+
+    /**
+     * Number of values per row, both halves of the frequency axis
+     */
+    uint32_t frequency_bins;
+
+    /**
+     * Output chip framerate (frames per second)
+     */
+    float fps;
+
+    /**
+     * Input FPS of this pulse-Doppler instance
+     */
+    float fps_decimated;
+
+    /**
+     * Frequency of the first column
+     */
+    float frequency_start;
+
+    /**
+     * Difference between each frequency bin
+     */
+    float frequency_step;
+
+    /**
+     * Number of rows not received in full. Missing values are 0.
+     */
+    uint32_t missing_rows;
+
+    /**
+     * Absolute range of each row
+     */
+    std::vector<float> range;
+
+    /**
+     * Non-zero for each row received in full
+     */
+    std::vector<unsigned char> row_complete;
+
+    /**
+     * The matrix values, range_bins * frequency_bins
+     */
+    std::vector<float> data;
+};
+
+/**
+ * @class PulseDopplerMatrixAssembler
+ *
+ * Collects the rows delivered by read_message_pulsedoppler_float or
+ * read_message_pulsedoppler_byte into complete range-Doppler matrices.
+ *
+ * Each pulse-Doppler instance (slow and fast) is assembled separately into two
+ * preallocated matrices: one being filled and one holding the last finished matrix.
+ * A matrix is published when all of its rows have been received, or with missing_rows
+ * set when a row of the next matrix_counter arrives first. Publishing swaps the two
+ * buffers, so no data is copied, and no memory is allocated once the matrix size of
+ * an instance is stable.
+ *
+ * A row can both end the previous matrix early and complete a new one, e.g. with a single
+ * range bin. The previous matrix is then returned first, and the new one is kept and
+ * returned by the next \ref add_row of the same instance, so both are delivered in order.
+ *
+ * Use one assembler per message format.
+ *
+ * @code
+ * PulseDopplerMatrixAssembler assembler;
+ * PulseDopplerByteData row;
+ * while (x4m300.read_message_pulsedoppler_byte(&row) == 0) {
+ *     const PulseDopplerMatrix *matrix = assembler.add_row(row);
+ *     if (matrix)
+ *         process(*matrix);
+ * }
+ * @endcode
+ */
+class PulseDopplerMatrixAssembler
+{
+public:
+    PulseDopplerMatrixAssembler() : incomplete_count(0) {}
+
+    /**
+     * Adds a float row.
+     *
+     * @return the matrix finished by this row, or nullptr. The matrix stays valid until
+     * the next matrix of the same instance is published.
+     */
+    const PulseDopplerMatrix * add_row(const PulseDopplerFloatData &row)
+    {
+        if (row.data.size() < row.frequency_count)
+            return nullptr;
+        const float *values = row.data.data();
+        return add(row, [values, &row](Instance &, float *out) {
+            std::copy(values, values + row.frequency_count, out);
+        });
+    }
+
+    /**
+     * Adds a byte row. The values are converted from dB to linear using byte_step_start
+     * and byte_step_size.
+     *
+     * @return the matrix finished by this row, or nullptr. The matrix stays valid until
+     * the next matrix of the same instance is published.
+     */
+    const PulseDopplerMatrix * add_row(const PulseDopplerByteData &row)
+    {
+        if (row.data.size() < row.frequency_count)
+            return nullptr;
+        const unsigned char *values = row.data.data();
+        return add(row, [values, &row](Instance &instance, float *out) {
+            if (!instance.table_valid || instance.table_start != row.byte_step_start ||
+                instance.table_size != row.byte_step_size) {
+                db_byte_table(row.byte_step_start, row.byte_step_size, instance.table);
+                instance.table_start = row.byte_step_start;
+                instance.table_size = row.byte_step_size;
+                instance.table_valid = true;
+            }
+            dequantize_bytes(values, out, row.frequency_count, instance.table);
+        });
+    }
+
+    /**
+     * @return the last matrix published for the given instance, or nullptr.
+     */
+    const PulseDopplerMatrix * latest(uint32_t pulsedoppler_instance) const
+    {
+        if (pulsedoppler_instance >= instances.size() || !instances[pulsedoppler_instance] ||
+            !instances[pulsedoppler_instance]->has_front)
+            return nullptr;
+        const Instance &instance = *instances[pulsedoppler_instance];
+        return &instance.buffers[instance.back ^ 1];
+    }
+
+    /**
+     * @return the number of matrices published with missing rows.
+     */
+    unsigned long incomplete_matrices() const { return incomplete_count; }
+
+private:
+    PulseDopplerMatrixAssembler(const PulseDopplerMatrixAssembler &other) = delete;
+    PulseDopplerMatrixAssembler& operator= (const PulseDopplerMatrixAssembler &other) = delete;
+
+    struct Instance
+    {
+        Instance() : back(0), has_rows(false), has_front(false), queued(false), rows_complete(0),
+            table_valid(false), table_start(0), table_size(0) {}
+        PulseDopplerMatrix buffers[2];
+        int back;
+        bool has_rows;
+        bool has_front;
+        // The back buffer holds a finished matrix not returned yet.
+        bool queued;
+        uint32_t rows_complete;
+        bool table_valid;
+        float table_start;
+        float table_size;
+        float table[256];
+    };
+
+    template<typename Row, typename Convert>
+    const PulseDopplerMatrix * add(const Row &row, Convert convert)
+    {
+        if (row.range_bins == 0 || row.range_idx >= row.range_bins || row.frequency_count == 0 ||
+            !(row.frequency_step > 0))
+            return nullptr;
+
+        if (row.pulsedoppler_instance >= instances.size())
+            instances.resize(row.pulsedoppler_instance + 1);
+        if (!instances[row.pulsedoppler_instance])
+            instances[row.pulsedoppler_instance].reset(new Instance);
+        Instance &instance = *instances[row.pulsedoppler_instance];
+
+        // The negative half of a row starts the frequency axis, the positive half ends it
+        // at the same distance from zero.
+        const float step = row.frequency_step;
+        const float axis_start = row.frequency_start < 0 ? row.frequency_start :
+            -(row.frequency_start + row.frequency_count * step);
+        const uint32_t width = std::max<uint32_t>(2 * static_cast<uint32_t>(std::lround(-axis_start / step)),
+                                                  row.frequency_count);
+
+        const PulseDopplerMatrix *published = nullptr;
+        if (instance.queued) {
+            instance.queued = false;
+            published = publish(instance);
+        } else if (instance.has_rows) {
+            const PulseDopplerMatrix &current = instance.buffers[instance.back];
+            if (current.matrix_counter != row.matrix_counter || current.range_bins != row.range_bins ||
+                current.frequency_bins != width)
+                published = publish(instance);
+        }
+        PulseDopplerMatrix &matrix = instance.buffers[instance.back];
+        if (!instance.has_rows)
+            start(instance, matrix, row, width, axis_start);
+
+        const long column = std::lround((row.frequency_start - matrix.frequency_start) / step);
+        if (column < 0 || static_cast<size_t>(column) + row.frequency_count > matrix.frequency_bins)
+            return published;
+        convert(instance, matrix.data.data() + row.range_idx * matrix.frequency_bins + column);
+
+        const bool negative = row.frequency_start < -step / 2;
+        const bool positive = row.frequency_start + (row.frequency_count - 1) * step > -step / 2;
+        unsigned char &halves = matrix.row_complete[row.range_idx];
+        const unsigned char received = halves | (negative ? 1 : 0) | (positive ? 2 : 0);
+        if (received == 3 && halves != 3)
+            ++instance.rows_complete;
+        halves = received;
+        matrix.range[row.range_idx] = row.range;
+        matrix.frame_counter = row.frame_counter;
+
+        if (instance.rows_complete == matrix.range_bins) {
+            // Only one matrix can be returned per row; keep this one for the next row.
+            if (published) {
+                instance.queued = true;
+                return published;
+            }
+            return publish(instance);
+        }
+        return published;
+    }
+
+    template<typename Row>
+    static void start(Instance &instance, PulseDopplerMatrix &matrix, const Row &row,
+                      uint32_t width, float frequency_start)
+    {
+        matrix.frame_counter = row.frame_counter;
+        matrix.matrix_counter = row.matrix_counter;
+        matrix.pulsedoppler_instance = row.pulsedoppler_instance;
+        matrix.range_bins = row.range_bins;
+        matrix.frequency_bins = width;
+        matrix.fps = row.fps;
+        matrix.fps_decimated = row.fps_decimated;
+        matrix.frequency_start = frequency_start;
+        matrix.frequency_step = row.frequency_step;
+        matrix.missing_rows = 0;
+        matrix.range.assign(row.range_bins, 0.0f);
+        matrix.row_complete.assign(row.range_bins, 0);
+        matrix.data.assign(static_cast<size_t>(row.range_bins) * width, 0.0f);
+        instance.rows_complete = 0;
+        instance.has_rows = true;
+    }
+
+    const PulseDopplerMatrix * publish(Instance &instance)
+    {
+        PulseDopplerMatrix &matrix = instance.buffers[instance.back];
+        matrix.missing_rows = matrix.range_bins - instance.rows_complete;
+        if (matrix.missing_rows)
+            ++incomplete_count;
+        instance.back ^= 1;
+        instance.has_rows = false;
+        instance.has_front = true;
+        return &matrix;
+    }
+
+    std::vector<std::unique_ptr<Instance> > instances;
+    unsigned long incomplete_count;
+};
+
+} // namespace XeThru
+
+#endif // PULSEDOPPLERMATRIX_HPP
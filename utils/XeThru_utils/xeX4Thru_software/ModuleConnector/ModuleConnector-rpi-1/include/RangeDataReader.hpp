@@ -0,0 +1,337 @@
+#ifndef RANGEDATAREADER_HPP
+#define RANGEDATAREADER_HPP
+
+#include "Data.hpp"
+#include "DataReader.hpp"
+#include "RecordingIndex.hpp"
+#include "datatypes.h"
+
+#include <cstring>
+#include <limits>
+#include <string>
+
+namespace XeThru {
+
+/**
+ * Reads the frame counter of a record, for the data types whose records start with it:
+ * baseband AP/IQ, radar RF, radar baseband, pulse-Doppler and noise map data.
+ *
+ * @param data_type Specifies the \ref DataType of the record.
+ * @param data Specifies the record bytes.
+ * @param size Specifies the number of record bytes.
+ * @param[out] frame_counter Specifies where to write the frame counter.
+ * @return true if the record has a frame counter, otherwise returns false.
+ */
+inline bool get_record_frame_counter(uint32_t data_type, const uint8_t *data, uint32_t size,
+                                     uint32_t *frame_counter)
+{
+    const uint32_t framed_types = BasebandApDataType | BasebandIqDataType |
+        PulseDopplerFloatDataType | PulseDopplerByteDataType | NoiseMapFloatDataType |
+        NoiseMapByteDataType | RadarRfDataType | RadarRfNormalizedDataType |
+        RadarBasebandFloatDataType | RadarBasebandQ15DataType;
+    if (!(data_type & framed_types) || size < sizeof(uint32_t))
+        return false;
+    std::memcpy(frame_counter, data, sizeof(uint32_t));
+    return true;
+}
+
+/**
+ * @struct RecordPredicate
+ *
+ * Selects records by data type, epoch range and frame counter range.
+ *
+ * The ranges include the begin value and exclude the end value. When a frame counter
+ * range is set, only records with a frame counter (see \ref get_record_frame_counter)
+ * match; user header records never do.
+ *
+ * @param data_types Specifies the data types as a bitmask of \ref DataType flags.
+ * @param begin_epoch Specifies the first epoch, as number of milliseconds since 1970.01.01.
+ * @param end_epoch Specifies the epoch after the last one.
+ * @param begin_frame Specifies the first frame counter.
+ * @param end_frame Specifies the frame counter after the last one.
+ *
+ * @see RangeDataReader
+ */
+struct RecordPredicate
+{
+    RecordPredicate() :
+        data_types(AllDataTypes),
+        begin_epoch(std::numeric_limits<int64_t>::min()),
+        end_epoch(std::numeric_limits<int64_t>::max()),
+        begin_frame(0),
+        end_frame(std::numeric_limits<uint32_t>::max())
+    {}
+
+    /**
+     * @return true if a frame counter range is set.
+     */
+    bool has_frame_range() const
+    {
+        return begin_frame != 0 || end_frame != std::numeric_limits<uint32_t>::max();
+    }
+
+    /**
+     * @return true if the record matches the predicate.
+     */
+    bool matches(uint32_t data_type, int64_t epoch, const uint8_t *data, uint32_t size,
+                 bool is_user_header) const
+    {
+        if (!(data_type & data_types) || epoch < begin_epoch || epoch >= end_epoch)
+            return false;
+        if (!has_frame_range())
+            return true;
+        uint32_t frame_counter;
+        return !is_user_header && get_record_frame_counter(data_type, data, size, &frame_counter) &&
+            frame_counter >= begin_frame && frame_counter < end_frame;
+    }
+
+    /**
+     * @return true if the record matches the predicate.
+     */
+    bool matches(const DataRecord &record) const
+    {
+        return matches(record.data_type, record.epoch, record.data.data(),
+                       static_cast<uint32_t>(record.data.size()), record.is_user_header);
+    }
+
+    /**
+     * @return true if the record and every record stored after it are past the end of the
+     * ranges, assuming epochs and frame counters do not decrease during a recording.
+     */
+    bool is_past_end(uint32_t data_type, int64_t epoch, const uint8_t *data, uint32_t size,
+                     bool is_user_header) const
+    {
+        if (epoch >= end_epoch)
+            return true;
+        uint32_t frame_counter;
+        return has_frame_range() && !is_user_header && (data_type & data_types) &&
+            get_record_frame_counter(data_type, data, size, &frame_counter) && frame_counter >= end_frame;
+    }
+
+    uint32_t data_types;
+    int64_t begin_epoch;
+    int64_t end_epoch;
+    uint32_t begin_frame;
+    uint32_t end_frame;
+};
+
+/**
+ * @class RangeDataReader
+ *
+ * The RangeDataReader class reads the records of a recording matching a \ref RecordPredicate.
+ *
+ * Instead of reading the whole recording and discarding what is outside the ranges, the
+ * reader seeks to the beginning of the epoch range, finds the beginning of the frame
+ * counter range by bisecting the recording in time, and stops at the first record past
+ * the end of the ranges. Extracting a short clip from a long recording therefore only
+ * reads the records around the clip. With a \ref RecordingIndex, see \ref set_index,
+ * the seeks go straight to the right record instead of scanning the meta file.
+ *
+ * @code
+ * RecordPredicate predicate;
+ * predicate.data_types = BasebandIqDataType;
+ * predicate.begin_frame = 10000;
+ * predicate.end_frame = 20000;
+ * RangeDataReader reader;
+ * if (reader.open(meta_filename, predicate) != 0)
+ *     return 1;
+ * DataRecord record;
+ * while (reader.read_record(&record) == 0)
+ *     process(record);
+ * @endcode
+ *
+ * @see DataReader, RecordPredicate
+ */
+class RangeDataReader
+{
+public:
+    /**
+     * Constructs reader.
+     */
+    RangeDataReader() : index(nullptr), pending_size(0), has_pending(false), done(true) {}
+
+    /**
+     * Opens a recording and positions the reader at the first record matching \a predicate.
+     * @param meta_filename Specifies which recording (*xethru_recording_meta.dat*) to open
+     * @param predicate Specifies the records to read.
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, const RecordPredicate &predicate, int depth = -1)
+    {
+        close();
+        if (reader.open(meta_filename, depth) != 0)
+            return 1;
+        pending.data.resize(reader.get_max_record_size());
+        return set_predicate(predicate);
+    }
+
+    /**
+     * @return true if the recording is successfully opened, otherwise returns false
+     */
+    bool is_open() const { return reader.is_open(); }
+
+    /**
+     * Sets the index used to seek the recording. Takes effect on the next \ref open or
+     * \ref set_predicate.
+     * @param recording_index Specifies the index of the recording, or nullptr to seek
+     * with \ref DataReader::seek_ms. It must outlive its use by the reader.
+     */
+    void set_index(const RecordingIndex *recording_index) { index = recording_index; }
+
+    /**
+     * Closes the recording.
+     */
+    void close()
+    {
+        reader.close();
+        has_pending = false;
+        done = true;
+    }
+
+    /**
+     * Replaces the predicate and positions the reader at the first record matching it.
+     * @return 0 on success, otherwise returns 1
+     */
+    int set_predicate(const RecordPredicate &predicate)
+    {
+        current = predicate;
+        has_pending = false;
+        done = false;
+        if (reader.set_filter(predicate.data_types) != 0 || seek_to_begin() != 0) {
+            done = true;
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @return the predicate used by the reader.
+     */
+    const RecordPredicate & get_predicate() const { return current; }
+
+    /**
+     * @return true if no more records matching the predicate are available, otherwise returns false.
+     */
+    bool at_end() { return !fill_pending(); }
+
+    /**
+     * Reads the next record matching the predicate into \a record, reusing its storage.
+     * @param[out] record Specifies the record to update.
+     * @return 0 on success, otherwise returns 1
+     */
+    int read_record(DataRecord *record)
+    {
+        if (!fill_pending()) {
+            record->is_valid = false;
+            return 1;
+        }
+        record->data.assign(pending.data.begin(), pending.data.begin() + pending_size);
+        record->data_type = pending.data_type;
+        record->epoch = pending.epoch;
+        record->is_user_header = pending.is_user_header;
+        record->meta_version = reader.get_meta_version();
+        record->is_valid = true;
+        has_pending = false;
+        return 0;
+    }
+
+    /**
+     * Reads the next record matching the predicate.
+     * @return the DataRecord, with DataRecord::is_valid false at the end.
+     */
+    DataRecord read_record()
+    {
+        DataRecord record;
+        read_record(&record);
+        return record;
+    }
+
+private:
+    RangeDataReader(const RangeDataReader &other) = delete;
+    RangeDataReader& operator= (const RangeDataReader &other) = delete;
+
+    int seek(int64_t position)
+    {
+        return index ? index->seek_ms(reader, position) : reader.seek_ms(position);
+    }
+
+    // Reads the next record of the recording into pending.
+    bool read_raw()
+    {
+        if (reader.at_end())
+            return false;
+        uint8_t is_user_header = 0;
+        if (reader.read_record(pending.data.data(), static_cast<uint32_t>(pending.data.size()), &pending_size,
+                               &pending.data_type, &pending.epoch, &is_user_header) != 0)
+            return false;
+        pending.is_user_header = is_user_header != 0;
+        return true;
+    }
+
+    bool fill_pending()
+    {
+        while (!has_pending && !done) {
+            if (!read_raw() || current.is_past_end(pending.data_type, pending.epoch, pending.data.data(),
+                                                   pending_size, pending.is_user_header)) {
+                done = true;
+                break;
+            }
+            has_pending = current.matches(pending.data_type, pending.epoch, pending.data.data(),
+                                          pending_size, pending.is_user_header);
+        }
+        return has_pending;
+    }
+
+    // Returns the first frame counter at or after the given position, or false if none.
+    bool frame_counter_at(int64_t position, uint32_t *frame_counter)
+    {
+        if (seek(position) != 0)
+            return false;
+        for (int n = 0; n < 64 && read_raw(); ++n) {
+            if (!pending.is_user_header &&
+                get_record_frame_counter(pending.data_type, pending.data.data(), pending_size, frame_counter))
+                return true;
+        }
+        return false;
+    }
+
+    int seek_to_begin()
+    {
+        const int64_t start_epoch = reader.get_start_epoch();
+        int64_t low = 0;
+        if (current.begin_epoch > start_epoch)
+            low = current.begin_epoch - start_epoch;
+        if (low > reader.get_duration()) {
+            done = true;
+            return 0;
+        }
+        if (current.has_frame_range() && current.begin_frame > 0) {
+            // Find the last position whose first frame counter is before the range.
+            int64_t high = reader.get_duration();
+            uint32_t frame_counter;
+            if (frame_counter_at(low, &frame_counter) && frame_counter < current.begin_frame) {
+                while (high - low > 1) {
+                    const int64_t middle = low + (high - low) / 2;
+                    if (frame_counter_at(middle, &frame_counter) && frame_counter < current.begin_frame)
+                        low = middle;
+                    else
+                        high = middle;
+                }
+            }
+        }
+        return seek(low);
+    }
+
+    DataReader reader;
+    const RecordingIndex *index;
+    RecordPredicate current;
+    DataRecord pending;
+    uint32_t pending_size;
+    bool has_pending;
+    bool done;
+};
+
+} // namespace XeThru
+
+#endif // RANGEDATAREADER_HPP
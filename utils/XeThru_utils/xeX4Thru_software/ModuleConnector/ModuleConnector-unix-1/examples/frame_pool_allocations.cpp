@@ -0,0 +1,173 @@
+#include "XEP.hpp"
+#include "X4M300.hpp"
+#include "ModuleConnector.hpp"
+#include "FramePool.hpp"
+#include "xtid.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+/** \example frame_pool_allocations.cpp
+ * this is a small example counting the heap allocations per frame when reading data float
+ * messages into a new DataFloat and into a FramePool, measuring the read latency
+ */
+
+using namespace XeThru;
+
+// Counts the allocations made by the reading thread while counting is enabled. The
+// receive thread of the connector is not counted.
+static thread_local bool counting = false;
+static thread_local unsigned long allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+    if (void *p = std::malloc(size > 0 ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void usage()
+{
+    std::cout << "Enter the port number of the device, and optionally the number of frames" << std::endl;
+}
+
+int handle_error(std::string message)
+{
+    std::cerr << "ERROR: " << message << std::endl;
+    return 1;
+}
+
+// Waits until a frame is queued, so that the measured latency excludes the frame interval.
+static void wait_for_frame(XEP &xep)
+{
+    while (xep.peek_message_data_float() <= 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+static void report(const char *name, unsigned long count, int frames, double seconds)
+{
+    std::cout << name << ": " << static_cast<double>(count) / frames << " allocations/frame, "
+              << seconds * 1e6 / frames << " us/frame" << std::endl;
+}
+
+int run(const std::string &device_name, int frames)
+{
+    const unsigned int log_level = 0;
+    ModuleConnector mc(device_name, log_level);
+    XEP &xep = mc.get_xep();
+
+    std::string FWID;
+    // If the module is a X4M200 or X4M300 it needs to be put in manual mode
+    xep.get_system_info(0x02, &FWID);
+    if (FWID != "XEP") {
+        X4M300 &x4m300 = mc.get_x4m300();
+        x4m300.set_sensor_mode(XTID_SM_STOP, 0);
+        x4m300.set_sensor_mode(XTID_SM_MANUAL, 0);
+    }
+    xep.x4driver_init();
+    xep.x4driver_set_downconversion(0);
+    xep.x4driver_set_fps(100);
+
+    // Reading into a new DataFloat allocates its data vector for every frame.
+    unsigned long count = 0;
+    std::chrono::steady_clock::duration elapsed(0);
+    for (int n = 0; n < frames; ++n) {
+        DataFloat data_float;
+        wait_for_frame(xep);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        counting = true;
+        allocations = 0;
+        const int status = xep.read_message_data_float(&data_float);
+        counting = false;
+        elapsed += std::chrono::steady_clock::now() - start;
+        count += allocations;
+        if (status != 0) {
+            xep.x4driver_set_fps(0);
+            return handle_error("read_message_data_float failed");
+        }
+    }
+    report("new DataFloat", count, frames,
+           std::chrono::duration<double>(elapsed).count());
+
+    // Reading into a pool reuses the frames released by the previous reads. The first
+    // frames are read before counting, so that the pool and the frame vectors have
+    // reached their steady size.
+    FramePool<DataFloat> pool(2);
+    FrameRef<DataFloat> frame;
+    for (int n = 0; n < 10; ++n) {
+        if (xep.read_message_data_float(pool, &frame) != 0) {
+            xep.x4driver_set_fps(0);
+            return handle_error("read_message_data_float failed");
+        }
+        frame.reset();
+    }
+    count = 0;
+    elapsed = std::chrono::steady_clock::duration(0);
+    for (int n = 0; n < frames; ++n) {
+        frame.reset();
+        wait_for_frame(xep);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        counting = true;
+        allocations = 0;
+        const int status = xep.read_message_data_float(pool, &frame);
+        counting = false;
+        elapsed += std::chrono::steady_clock::now() - start;
+        count += allocations;
+        if (status != 0) {
+            xep.x4driver_set_fps(0);
+            return handle_error("read_message_data_float failed");
+        }
+    }
+    report("FramePool", count, frames,
+           std::chrono::duration<double>(elapsed).count());
+
+    xep.x4driver_set_fps(0);
+    if (count != 0)
+        return handle_error("reading into a FramePool allocated in steady state");
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        usage();
+        return 2;
+    }
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 1000;
+    if (frames <= 0) {
+        usage();
+        return 2;
+    }
+    return run(argv[1], frames);
+}
@@ -1,4 +1,5 @@
 #include "ModuleConnector.hpp"
+#include "PulseDopplerMatrix.hpp"
 #include "X4M300.hpp"
 #include "xtid.h"
 
@@ -49,14 +50,19 @@ int pulsedoppler(const std::string & device_name)
         return 1;
     }
 
+    PulseDopplerMatrixAssembler assembler;
+    PulseDopplerFloatData data;
     for (int i = 0; i < NUM_PD_MESSAGES; ++i) {
-        PulseDopplerFloatData data;
         if (x4m300.read_message_pulsedoppler_float(&data) != 0) {
             std::cerr << "Error: couldn't read pd message #" << i << std::endl;
             return 1;
         }
-        std::cout << "PD " << data.pulsedoppler_instance << ", frame " <<
-            data.frame_counter << ", range idx " << data.range_idx << std::endl;
+        const PulseDopplerMatrix *matrix = assembler.add_row(data);
+        if (!matrix)
+            continue;
+        std::cout << "PD " << matrix->pulsedoppler_instance << ", matrix " <<
+            matrix->matrix_counter << ", " << matrix->range_bins << "x" <<
+            matrix->frequency_bins << ", missing rows " << matrix->missing_rows << std::endl;
     }
 
     x4m300.set_sensor_mode(XTID_SM_STOP, 0);
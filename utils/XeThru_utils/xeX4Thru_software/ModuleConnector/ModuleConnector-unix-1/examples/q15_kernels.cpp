@@ -0,0 +1,106 @@
+#include "RadarKernels.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/** \example q15_kernels.cpp
+ * this is a small example checking that every SIMD variant of q15_to_float, and the one
+ * selected at runtime, converts bit for bit like the scalar code, measuring the throughput
+ * of each
+ */
+
+using namespace XeThru;
+
+struct Variant
+{
+    std::string name;
+    detail::Q15ToFloatFunction convert;
+};
+
+static std::vector<Variant> variants()
+{
+    std::vector<Variant> result;
+    result.push_back(Variant{ "scalar", &detail::q15_to_float_scalar });
+#if defined(XETHRU_KERNELS_SSE2)
+    result.push_back(Variant{ "sse2", &detail::q15_to_float_sse2 });
+#endif
+#if defined(XETHRU_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        result.push_back(Variant{ "avx2", &detail::q15_to_float_avx2 });
+#endif
+#if defined(XETHRU_KERNELS_NEON)
+    result.push_back(Variant{ "neon", &detail::q15_to_float_neon });
+#endif
+    result.push_back(Variant{ "dispatch", &q15_to_float });
+    return result;
+}
+
+// Converts every Q15 value, at every offset and length up to two AVX2 blocks so that
+// the vector loops and the scalar tails are all covered.
+static bool check(const Variant &variant)
+{
+    const float scales[] = { 1.0f, 1.0f / 32768.0f, 0.000123f, -3.5f };
+    std::vector<int16_t> in(65536 + 64);
+    for (size_t n = 0; n < in.size(); ++n)
+        in[n] = static_cast<int16_t>(static_cast<uint16_t>(n * 40503u));
+    std::vector<float> expected(in.size());
+    std::vector<float> actual(in.size());
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); ++s) {
+        detail::q15_to_float_scalar(in.data(), expected.data(), in.size(), scales[s]);
+        variant.convert(in.data(), actual.data(), in.size(), scales[s]);
+        if (std::memcmp(expected.data(), actual.data(), in.size() * sizeof(float)) != 0)
+            return false;
+        for (size_t offset = 0; offset < 8; ++offset) {
+            for (size_t count = 0; count <= 40; ++count) {
+                detail::q15_to_float_scalar(in.data() + offset, expected.data(), count, scales[s]);
+                // Marks the float after the last one, which must stay untouched.
+                actual[count] = -1.0f;
+                variant.convert(in.data() + offset, actual.data(), count, scales[s]);
+                if ((count > 0 && std::memcmp(expected.data(), actual.data(), count * sizeof(float)) != 0) ||
+                    actual[count] != -1.0f)
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+static double throughput(const Variant &variant)
+{
+    // One baseband frame of I and Q samples, converted repeatedly.
+    const size_t count = 2 * 1536;
+    const int iterations = 20000;
+    std::vector<int16_t> in(count);
+    for (size_t n = 0; n < count; ++n)
+        in[n] = static_cast<int16_t>(n * 37);
+    std::vector<float> out(count);
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; ++n)
+        variant.convert(in.data(), out.data(), count, 1.0f / 32768.0f);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    // Keeps the conversions from being optimized away.
+    volatile float sink = out[count / 2];
+    (void)sink;
+    return static_cast<double>(count) * iterations / seconds;
+}
+
+int main()
+{
+    const std::vector<Variant> all = variants();
+    int failures = 0;
+    for (size_t n = 0; n < all.size(); ++n) {
+        const bool ok = check(all[n]);
+        if (!ok)
+            ++failures;
+        std::cout << all[n].name << ": " << (ok ? "bit identical" : "MISMATCH") << ", "
+                  << throughput(all[n]) / 1e6 << " Msamples/s" << std::endl;
+    }
+    if (failures > 0) {
+        std::cerr << "ERROR: " << failures << " variants differ from the scalar conversion" << std::endl;
+        return 1;
+    }
+    return 0;
+}
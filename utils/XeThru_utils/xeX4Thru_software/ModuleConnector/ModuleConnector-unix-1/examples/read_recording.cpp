@@ -90,6 +90,25 @@ int read_recording(const std::string &meta_filename)
     }
 //! [Typical usage with raw buffer]
 
+    std::cout << "--- Read baseband ap records from the start ---" << std::endl;
+    if (reader.seek_ms(0) != 0) {
+        std::cout << "ERROR: failed to seek" << std::endl;
+        return 1;
+    }
+
+//! [Typical usage with record range]
+    RecordRange range = reader.records(BasebandApDataType);
+    for (const RecordView &record : range) {
+        // record.data points to record.size bytes, valid until the next record is read.
+        std::cout << "read record of data type: " << record.data_type
+                  << ", size: " << record.size << std::endl;
+    }
+    if (range.has_failed()) {
+        std::cout << "ERROR: failed to read record" << std::endl;
+        return 1;
+    }
+//! [Typical usage with record range]
+
     return 0;
 }
 
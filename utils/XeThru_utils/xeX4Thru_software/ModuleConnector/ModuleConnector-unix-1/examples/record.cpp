@@ -74,8 +74,10 @@ int record(const std::string &device_name)
     x2m200.enable_baseband_ap();
     x2m200.set_sensor_mode_run();
 
+    // The recorder is fed on the connector's receive thread and no messages are read
+    // here, so there is nothing to wait_for_message on; just wait for Ctrl+C.
     while (!stop_recording) {
-        usleep(1000);
+        usleep(100000);
     }
 
     return 0;
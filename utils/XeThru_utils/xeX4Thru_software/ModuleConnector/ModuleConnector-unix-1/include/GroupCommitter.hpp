@@ -0,0 +1,399 @@
+#ifndef GROUPCOMMITTER_HPP
+#define GROUPCOMMITTER_HPP
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+
+#include "DataRecorder.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace XeThru {
+
+/**
+ * @struct GroupCommitStats
+ *
+ * Durability statistics of a \ref GroupCommitter.
+ *
+ * @param commit_count Specifies the number of commits that synced data.
+ * @param failure_count Specifies the number of files and directories that failed to sync. Files
+ * removed or renamed since they were sampled are not counted.
+ * @param last_latency_ms Specifies the duration of the last commit in milliseconds.
+ * @param max_latency_ms Specifies the longest commit in milliseconds.
+ * @param mean_latency_ms Specifies the mean commit duration in milliseconds.
+ * @param bytes_at_risk Specifies the bytes written but not yet committed, as last sampled.
+ * @param max_bytes_at_risk Specifies the largest \a bytes_at_risk seen.
+ * @param committed_bytes Specifies the total bytes committed.
+ */
+struct GroupCommitStats
+{
+    GroupCommitStats() : commit_count(0), failure_count(0), last_latency_ms(0), max_latency_ms(0),
+        mean_latency_ms(0), bytes_at_risk(0), max_bytes_at_risk(0), committed_bytes(0) {}
+
+    uint64_t commit_count;
+    uint64_t failure_count;
+    double last_latency_ms;
+    double max_latency_ms;
+    double mean_latency_ms;
+    uint64_t bytes_at_risk;
+    uint64_t max_bytes_at_risk;
+    uint64_t committed_bytes;
+};
+
+/**
+ * @class GroupCommitter
+ *
+ * The GroupCommitter class makes a recording durable in groups of writes, as a middle
+ * ground between \ref RecordingOptions::set_flush_on_write and relying on the page cache.
+ *
+ * A background thread samples the size of the files in the active recording directories
+ * of the recorder. Once the data written since the last commit is older than the time
+ * window or larger than the byte window, the files that grew are synced with fdatasync,
+ * and their directory with fsync when files appeared or were renamed. Files are followed
+ * by inode across the rename the recorder does when it finishes a file. A power cut then
+ * loses at most about one window of the data written to the files, while the recorder
+ * keeps writing at page cache speed.
+ *
+ * The committer only sees data the recorder has written to its files. Unless
+ * \ref RecordingOptions::set_flush_on_write is enabled, \ref DataRecorder collects records
+ * in a user-space buffer first, and that buffer is lost on a power cut or crash on top of
+ * the window, and is not counted in \ref GroupCommitStats::bytes_at_risk. For the window
+ * to bound the loss, enable flush_on_write together with the committer: every record then
+ * reaches the page cache with one write call, and the committer replaces the disk syncs.
+ * \ref get_stats reports the commit latency and the bytes at risk.
+ *
+ * @code
+ * RecordingOptions options;
+ * options.set_flush_on_write(true);
+ * recorder.start_recording(BasebandIqDataType, directory, options);
+ * GroupCommitter committer(recorder, BasebandIqDataType, directory);
+ * committer.set_window(200, 4 * 1024 * 1024);
+ * committer.start();
+ * // ... record ...
+ * committer.stop(); // commits the rest
+ * recorder.stop_recording(AllDataTypes);
+ * @endcode
+ *
+ * @see DataRecorder, RecordingOptions::set_flush_on_write
+ */
+class GroupCommitter
+{
+public:
+    /**
+     * Constructs the committer.
+     * @param data_recorder Specifies the recorder whose files to commit. It must outlive this object.
+     * @param data_types Specifies the data types whose recording directories to commit.
+     * @param directory Specifies the directory passed to \ref DataRecorder::start_recording.
+     */
+    GroupCommitter(DataRecorder &data_recorder, DataTypes data_types, const std::string &directory) :
+        recorder(data_recorder), committed_types(data_types), base_directory(directory),
+        max_ms(200), max_bytes(4 * 1024 * 1024), pending_since(0), stopping(false) {}
+
+    /**
+     * Stops the background thread, committing the data written so far.
+     */
+    ~GroupCommitter() { stop(); }
+
+    /**
+     * Sets the durability window.
+     * @param window_ms Specifies the longest time written data stays uncommitted.
+     * @param window_bytes Specifies the most bytes that stay uncommitted.
+     */
+    void set_window(int64_t window_ms, uint64_t window_bytes)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_ms = std::max<int64_t>(window_ms, 1);
+        max_bytes = window_bytes;
+    }
+
+    /**
+     * Starts the background thread.
+     * @return 0 on success, otherwise returns 1
+     */
+    int start()
+    {
+        if (worker.joinable())
+            return 1;
+        stopping = false;
+        worker = std::thread(&GroupCommitter::run, this);
+        return 0;
+    }
+
+    /**
+     * Stops the background thread, committing the data written so far. Commits even if
+     * the thread was never started.
+     */
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable())
+            worker.join();
+        else
+            commit();
+    }
+
+    /**
+     * Commits the data written so far on the calling thread.
+     * @return 0 on success, otherwise returns 1
+     */
+    int commit()
+    {
+        std::lock_guard<std::mutex> commit_lock(commit_mutex);
+        scan();
+        return sync() ? 0 : 1;
+    }
+
+    /**
+     * @return the durability statistics.
+     */
+    GroupCommitStats get_stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+private:
+    GroupCommitter(const GroupCommitter &other) = delete;
+    GroupCommitter& operator= (const GroupCommitter &other) = delete;
+
+    struct FileState
+    {
+        FileState() : size(0), committed_size(0), seen(false) {}
+        std::string path;
+        uint64_t size;
+        uint64_t committed_size;
+        bool seen;
+    };
+
+    // Files are tracked by device and inode, since the recorder writes each file under a
+    // temporary name and renames it when done.
+    typedef std::pair<dev_t, ino_t> FileKey;
+
+    static int64_t now_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    std::string full_path(const std::string &directory) const
+    {
+        if (directory.empty() || directory[0] == '/' || base_directory.empty())
+            return directory;
+        return base_directory + "/" + directory;
+    }
+
+    static std::string directory_of(const std::string &path)
+    {
+        return path.substr(0, path.find_last_of('/'));
+    }
+
+    // Samples the size of the files in the active recording directories, and in the
+    // directories no longer recorded to that still hold uncommitted files, so their last
+    // writes are committed. Files no longer listed were removed and are forgotten.
+    void scan()
+    {
+        active_directories.clear();
+        for (uint32_t bit = 1; bit != 0; bit <<= 1) {
+            if ((committed_types & bit) && recorder.is_recording(static_cast<DataType>(bit))) {
+                const std::string directory = recorder.get_recording_directory(static_cast<DataType>(bit));
+                if (!directory.empty())
+                    active_directories.insert(full_path(directory));
+            }
+        }
+        std::set<std::string> directories = active_directories;
+        for (std::map<FileKey, FileState>::iterator file = files.begin(); file != files.end(); ++file) {
+            directories.insert(directory_of(file->second.path));
+            file->second.seen = false;
+        }
+        uint64_t at_risk = 0;
+        for (std::set<std::string>::const_iterator it = directories.begin(); it != directories.end(); ++it) {
+            DIR *dir = ::opendir(it->c_str());
+            if (!dir)
+                continue;
+            while (struct dirent *entry = ::readdir(dir)) {
+                const std::string path = *it + "/" + entry->d_name;
+                struct stat st;
+                if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+                    continue;
+                std::map<FileKey, FileState>::iterator file = files.find(FileKey(st.st_dev, st.st_ino));
+                if (file == files.end()) {
+                    if (!active_directories.count(*it))
+                        continue;
+                    file = files.insert(std::make_pair(FileKey(st.st_dev, st.st_ino), FileState())).first;
+                }
+                if (file->second.path != path) {
+                    // A new or renamed file, whose directory entry must be committed too.
+                    file->second.path = path;
+                    new_entries.insert(*it);
+                }
+                file->second.seen = true;
+                file->second.size = static_cast<uint64_t>(st.st_size);
+                if (file->second.size > file->second.committed_size)
+                    at_risk += file->second.size - file->second.committed_size;
+            }
+            ::closedir(dir);
+        }
+        for (std::map<FileKey, FileState>::iterator file = files.begin(); file != files.end();) {
+            if (file->second.seen)
+                ++file;
+            else
+                file = files.erase(file);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.bytes_at_risk = at_risk;
+        stats.max_bytes_at_risk = std::max(stats.max_bytes_at_risk, at_risk);
+        if (at_risk == 0)
+            pending_since = 0;
+        else if (pending_since == 0)
+            pending_since = now_ms();
+    }
+
+    enum SyncResult
+    {
+        Synced,
+        Gone,
+        Failed
+    };
+
+    // Syncs the file or directory at path, if it still is the one sampled. A file renamed
+    // or removed since it was sampled is not a failure.
+    static SyncResult sync_file(const std::string &path, const FileKey *key)
+    {
+        const int fd = ::open(path.c_str(), key ? O_RDONLY : O_RDONLY | O_DIRECTORY);
+        if (fd < 0)
+            return errno == ENOENT ? Gone : Failed;
+        struct stat st;
+        if (key && (::fstat(fd, &st) != 0 || FileKey(st.st_dev, st.st_ino) != *key)) {
+            ::close(fd);
+            return Gone;
+        }
+#if defined(__APPLE__)
+        const int status = ::fsync(fd);
+#else
+        const int status = key ? ::fdatasync(fd) : ::fsync(fd);
+#endif
+        ::close(fd);
+        return status == 0 ? Synced : Failed;
+    }
+
+    // Syncs the files that grew since the last commit. Files of directories no longer
+    // recorded to are forgotten once committed.
+    bool sync()
+    {
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        uint64_t committed = 0;
+        uint64_t failures = 0;
+        for (std::map<FileKey, FileState>::iterator it = files.begin(); it != files.end();) {
+            FileState &file = it->second;
+            if (file.size != file.committed_size) {
+                const SyncResult result = sync_file(file.path, &it->first);
+                if (result == Failed)
+                    ++failures;
+                if (result != Synced) {
+                    // Sampled again by the next scan under its new name, if renamed.
+                    ++it;
+                    continue;
+                }
+                if (file.size > file.committed_size)
+                    committed += file.size - file.committed_size;
+                file.committed_size = file.size;
+            }
+            if (active_directories.count(directory_of(file.path)))
+                ++it;
+            else
+                it = files.erase(it);
+        }
+        std::set<std::string> unsynced;
+        for (std::set<std::string>::const_iterator it = new_entries.begin(); it != new_entries.end(); ++it) {
+            const SyncResult result = sync_file(*it, nullptr);
+            if (result == Failed) {
+                ++failures;
+                unsynced.insert(*it);
+            }
+        }
+        const bool synced = committed > 0 || new_entries.size() > unsynced.size();
+        new_entries.swap(unsynced);
+        const double latency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.failure_count += failures;
+        if (synced) {
+            ++stats.commit_count;
+            stats.last_latency_ms = latency;
+            stats.max_latency_ms = std::max(stats.max_latency_ms, latency);
+            stats.mean_latency_ms += (latency - stats.mean_latency_ms) / static_cast<double>(stats.commit_count);
+            stats.committed_bytes += committed;
+        }
+        stats.bytes_at_risk = 0;
+        pending_since = 0;
+        return failures == 0;
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            // Sample several times per window, so a commit is at most a quarter window late.
+            const int64_t poll_ms = std::max<int64_t>(1, std::min<int64_t>(max_ms / 4, 50));
+            wake.wait_for(lock, std::chrono::milliseconds(poll_ms));
+            if (stopping)
+                break;
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> commit_lock(commit_mutex);
+                scan();
+                bool due;
+                {
+                    std::lock_guard<std::mutex> stats_lock(mutex);
+                    due = pending_since != 0 &&
+                        (stats.bytes_at_risk >= max_bytes || now_ms() - pending_since >= max_ms);
+                }
+                if (due)
+                    sync();
+            }
+            lock.lock();
+        }
+        lock.unlock();
+        commit();
+    }
+
+    DataRecorder &recorder;
+    const DataTypes committed_types;
+    const std::string base_directory;
+    mutable std::mutex mutex;
+    std::mutex commit_mutex;
+    std::condition_variable wake;
+    int64_t max_ms;
+    uint64_t max_bytes;
+    int64_t pending_since;
+    bool stopping;
+    GroupCommitStats stats;
+    std::map<FileKey, FileState> files;
+    std::set<std::string> active_directories;
+    std::set<std::string> new_entries;
+    std::thread worker;
+};
+
+} // namespace XeThru
+
+#endif // !_WIN32
+
+#endif // GROUPCOMMITTER_HPP
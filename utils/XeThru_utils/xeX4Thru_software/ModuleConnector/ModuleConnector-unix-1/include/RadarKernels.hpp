@@ -0,0 +1,503 @@
+#ifndef RADARKERNELS_HPP
+#define RADARKERNELS_HPP
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define XETHRU_KERNELS_SSE2 1
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && defined(XETHRU_KERNELS_SSE2)
+#include <immintrin.h>
+#define XETHRU_KERNELS_AVX2 1
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define XETHRU_KERNELS_NEON 1
+#endif
+
+namespace XeThru {
+
+/**
+ * @struct ComplexQ15
+ *
+ * One interleaved Q15 I/Q sample, as stored by \ref RadarBasebandQ15Data::get_iq.
+ */
+struct ComplexQ15
+{
+    int16_t i;
+    int16_t q;
+};
+
+/**
+ * Interleaves separate I and Q arrays into complex samples.
+ *
+ * @param i Specifies the in phase values.
+ * @param q Specifies the quadrature phase values.
+ * @param[out] iq Specifies where to write \a count complex samples.
+ * @param count Specifies the number of samples.
+ */
+inline void interleave_iq(const float *i, const float *q, std::complex<float> *iq, size_t count)
+{
+    // std::complex<float> is layout compatible with float[2]
+    float *out = reinterpret_cast<float *>(iq);
+    size_t n = 0;
+#if defined(XETHRU_KERNELS_SSE2)
+    for (; n + 4 <= count; n += 4) {
+        const __m128 vi = _mm_loadu_ps(i + n);
+        const __m128 vq = _mm_loadu_ps(q + n);
+        _mm_storeu_ps(out + 2 * n, _mm_unpacklo_ps(vi, vq));
+        _mm_storeu_ps(out + 2 * n + 4, _mm_unpackhi_ps(vi, vq));
+    }
+#elif defined(XETHRU_KERNELS_NEON)
+    for (; n + 4 <= count; n += 4) {
+        float32x4x2_t v;
+        v.val[0] = vld1q_f32(i + n);
+        v.val[1] = vld1q_f32(q + n);
+        vst2q_f32(out + 2 * n, v);
+    }
+#endif
+    for (; n < count; ++n) {
+        out[2 * n] = i[n];
+        out[2 * n + 1] = q[n];
+    }
+}
+
+/**
+ * Interleaves separate Q15 I and Q arrays into \ref ComplexQ15 samples.
+ *
+ * @param i Specifies the in phase values.
+ * @param q Specifies the quadrature phase values.
+ * @param[out] iq Specifies where to write \a count complex samples.
+ * @param count Specifies the number of samples.
+ */
+inline void interleave_iq(const int16_t *i, const int16_t *q, ComplexQ15 *iq, size_t count)
+{
+    int16_t *out = reinterpret_cast<int16_t *>(iq);
+    size_t n = 0;
+#if defined(XETHRU_KERNELS_SSE2)
+    for (; n + 8 <= count; n += 8) {
+        const __m128i vi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(i + n));
+        const __m128i vq = _mm_loadu_si128(reinterpret_cast<const __m128i *>(q + n));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * n), _mm_unpacklo_epi16(vi, vq));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * n + 8), _mm_unpackhi_epi16(vi, vq));
+    }
+#elif defined(XETHRU_KERNELS_NEON)
+    for (; n + 8 <= count; n += 8) {
+        int16x8x2_t v;
+        v.val[0] = vld1q_s16(i + n);
+        v.val[1] = vld1q_s16(q + n);
+        vst2q_s16(out + 2 * n, v);
+    }
+#endif
+    for (; n < count; ++n) {
+        out[2 * n] = i[n];
+        out[2 * n + 1] = q[n];
+    }
+}
+
+namespace detail {
+
+inline void q15_to_float_scalar(const int16_t *in, float *out, size_t count, float scale)
+{
+    for (size_t n = 0; n < count; ++n)
+        out[n] = static_cast<float>(in[n]) * scale;
+}
+
+#if defined(XETHRU_KERNELS_SSE2)
+inline void q15_to_float_sse2(const int16_t *in, float *out, size_t count, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + n));
+        // sign extend by placing each value in the upper half and shifting down
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + n, _mm_mul_ps(_mm_cvtepi32_ps(lo), vscale));
+        _mm_storeu_ps(out + n + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), vscale));
+    }
+    q15_to_float_scalar(in + n, out + n, count - n, scale);
+}
+#endif
+
+#if defined(XETHRU_KERNELS_AVX2)
+__attribute__((target("avx2")))
+inline void q15_to_float_avx2(const int16_t *in, float *out, size_t count, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    size_t n = 0;
+    for (; n + 16 <= count; n += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + n));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + n + 8));
+        _mm256_storeu_ps(out + n, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(lo)), vscale));
+        _mm256_storeu_ps(out + n + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(hi)), vscale));
+    }
+    q15_to_float_sse2(in + n, out + n, count - n, scale);
+}
+#endif
+
+#if defined(XETHRU_KERNELS_NEON)
+inline void q15_to_float_neon(const int16_t *in, float *out, size_t count, float scale)
+{
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const int16x8_t v = vld1q_s16(in + n);
+        vst1q_f32(out + n, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(v))), scale));
+        vst1q_f32(out + n + 4, vmulq_n_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(v))), scale));
+    }
+    q15_to_float_scalar(in + n, out + n, count - n, scale);
+}
+#endif
+
+typedef void (*Q15ToFloatFunction)(const int16_t *, float *, size_t, float);
+
+inline Q15ToFloatFunction select_q15_to_float()
+{
+#if defined(XETHRU_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return &q15_to_float_avx2;
+#endif
+#if defined(XETHRU_KERNELS_SSE2)
+    return &q15_to_float_sse2;
+#elif defined(XETHRU_KERNELS_NEON)
+    return &q15_to_float_neon;
+#else
+    return &q15_to_float_scalar;
+#endif
+}
+
+} // namespace detail
+
+/**
+ * Converts Q15 samples to float and applies a scaling factor, i.e. out = in * scale.
+ *
+ * The implementation is selected once at runtime: AVX2 when the CPU supports it,
+ * otherwise SSE2 on x86, NEON on ARM builds with NEON enabled, or plain C++.
+ * All variants convert exactly and round only in the multiplication, so they produce
+ * bit identical results. To convert a batch of frames stored back to back, call this
+ * once for the whole batch.
+ *
+ * @param in Specifies the Q15 samples.
+ * @param[out] out Specifies where to write \a count float samples.
+ * @param count Specifies the number of samples.
+ * @param scale Specifies the scaling factor, e.g. \ref RadarBasebandQ15Data::scaling_factor.
+ */
+inline void q15_to_float(const int16_t *in, float *out, size_t count, float scale)
+{
+    static const detail::Q15ToFloatFunction convert = detail::select_q15_to_float();
+    convert(in, out, count, scale);
+}
+
+namespace detail {
+
+// i' + jq' = (i + jq) * (c - js), i.e. a rotation by -atan2(s, c)
+inline void rotate_iq_scalar(float *i, float *q, size_t count, float c, float s)
+{
+    for (size_t n = 0; n < count; ++n) {
+        const float in_i = i[n];
+        const float in_q = q[n];
+        i[n] = in_i * c + in_q * s;
+        q[n] = in_q * c - in_i * s;
+    }
+}
+
+#if defined(XETHRU_KERNELS_SSE2)
+inline void rotate_iq_sse2(float *i, float *q, size_t count, float c, float s)
+{
+    const __m128 vc = _mm_set1_ps(c);
+    const __m128 vs = _mm_set1_ps(s);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const __m128 vi = _mm_loadu_ps(i + n);
+        const __m128 vq = _mm_loadu_ps(q + n);
+        _mm_storeu_ps(i + n, _mm_add_ps(_mm_mul_ps(vi, vc), _mm_mul_ps(vq, vs)));
+        _mm_storeu_ps(q + n, _mm_sub_ps(_mm_mul_ps(vq, vc), _mm_mul_ps(vi, vs)));
+    }
+    rotate_iq_scalar(i + n, q + n, count - n, c, s);
+}
+#endif
+
+#if defined(XETHRU_KERNELS_AVX2)
+__attribute__((target("avx2")))
+inline void rotate_iq_avx2(float *i, float *q, size_t count, float c, float s)
+{
+    const __m256 vc = _mm256_set1_ps(c);
+    const __m256 vs = _mm256_set1_ps(s);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const __m256 vi = _mm256_loadu_ps(i + n);
+        const __m256 vq = _mm256_loadu_ps(q + n);
+        _mm256_storeu_ps(i + n, _mm256_add_ps(_mm256_mul_ps(vi, vc), _mm256_mul_ps(vq, vs)));
+        _mm256_storeu_ps(q + n, _mm256_sub_ps(_mm256_mul_ps(vq, vc), _mm256_mul_ps(vi, vs)));
+    }
+    rotate_iq_sse2(i + n, q + n, count - n, c, s);
+}
+#endif
+
+#if defined(XETHRU_KERNELS_NEON)
+inline void rotate_iq_neon(float *i, float *q, size_t count, float c, float s)
+{
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const float32x4_t vi = vld1q_f32(i + n);
+        const float32x4_t vq = vld1q_f32(q + n);
+        vst1q_f32(i + n, vaddq_f32(vmulq_n_f32(vi, c), vmulq_n_f32(vq, s)));
+        vst1q_f32(q + n, vsubq_f32(vmulq_n_f32(vq, c), vmulq_n_f32(vi, s)));
+    }
+    rotate_iq_scalar(i + n, q + n, count - n, c, s);
+}
+#endif
+
+typedef void (*RotateIqFunction)(float *, float *, size_t, float, float);
+
+inline RotateIqFunction select_rotate_iq()
+{
+#if defined(XETHRU_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return &rotate_iq_avx2;
+#endif
+#if defined(XETHRU_KERNELS_SSE2)
+    return &rotate_iq_sse2;
+#elif defined(XETHRU_KERNELS_NEON)
+    return &rotate_iq_neon;
+#else
+    return &rotate_iq_scalar;
+#endif
+}
+
+} // namespace detail
+
+/**
+ * Applies phase noise correction to split I/Q samples in place.
+ *
+ * Every sample is rotated by the negative phase of the correction vector
+ * correction_i + j * correction_q, which removes the common phase drift measured by the
+ * module in the correction bin. The amplitude is left unchanged. Nothing is done if the
+ * correction vector is zero. The implementation is selected at runtime like \ref q15_to_float.
+ *
+ * @param[in,out] i Specifies the in phase values.
+ * @param[in,out] q Specifies the quadrature phase values.
+ * @param count Specifies the number of samples.
+ * @param correction_i Specifies the in phase part of the correction, e.g. \ref RadarBasebandFloatData::correction_i.
+ * @param correction_q Specifies the quadrature part of the correction.
+ */
+inline void apply_phase_correction(float *i, float *q, size_t count, float correction_i, float correction_q)
+{
+    static const detail::RotateIqFunction rotate = detail::select_rotate_iq();
+    const float magnitude = std::sqrt(correction_i * correction_i + correction_q * correction_q);
+    if (!(magnitude > 0.0f))
+        return;
+    rotate(i, q, count, correction_i / magnitude, correction_q / magnitude);
+}
+
+namespace detail {
+
+// atan(a) for a in [0, 1] as an odd polynomial of degree 11. |error| < 1.7e-6 rad for the
+// polynomial and < 1.8e-6 rad evaluated in float; the folded phase is within 2e-6 rad of atan2.
+inline float atan_unit(float a)
+{
+    const float s = a * a;
+    return a * (0.99997726f + s * (-0.33262347f + s * (0.19354346f + s * (-0.11643287f
+           + s * (0.05265332f + s * -0.01172120f)))));
+}
+
+inline void amplitude_phase_scalar(const float *i, const float *q, float *amplitude, float *phase, size_t count)
+{
+    const float pi = 3.14159265f;
+    for (size_t n = 0; n < count; ++n) {
+        const float x = i[n];
+        const float y = q[n];
+        const float ax = std::fabs(x);
+        const float ay = std::fabs(y);
+        const float max = ax > ay ? ax : ay;
+        const float min = ax > ay ? ay : ax;
+        float r = atan_unit(max > 0.0f ? min / max : 0.0f);
+        if (ay > ax)
+            r = pi / 2 - r;
+        if (x < 0.0f)
+            r = pi - r;
+        if (y < 0.0f)
+            r = -r;
+        amplitude[n] = std::sqrt(x * x + y * y);
+        phase[n] = r;
+    }
+}
+
+#if defined(XETHRU_KERNELS_SSE2)
+inline __m128 select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline void amplitude_phase_sse2(const float *i, const float *q, float *amplitude, float *phase, size_t count)
+{
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 pi = _mm_set1_ps(3.14159265f);
+    const __m128 half_pi = _mm_set1_ps(3.14159265f / 2);
+    size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const __m128 x = _mm_loadu_ps(i + n);
+        const __m128 y = _mm_loadu_ps(q + n);
+        const __m128 ax = _mm_andnot_ps(sign, x);
+        const __m128 ay = _mm_andnot_ps(sign, y);
+        const __m128 max = _mm_max_ps(ax, ay);
+        const __m128 a = _mm_and_ps(_mm_div_ps(_mm_min_ps(ax, ay), max), _mm_cmpgt_ps(max, zero));
+        const __m128 s = _mm_mul_ps(a, a);
+        __m128 r = _mm_add_ps(_mm_set1_ps(0.05265332f), _mm_mul_ps(s, _mm_set1_ps(-0.01172120f)));
+        r = _mm_add_ps(_mm_set1_ps(-0.11643287f), _mm_mul_ps(s, r));
+        r = _mm_add_ps(_mm_set1_ps(0.19354346f), _mm_mul_ps(s, r));
+        r = _mm_add_ps(_mm_set1_ps(-0.33262347f), _mm_mul_ps(s, r));
+        r = _mm_mul_ps(a, _mm_add_ps(_mm_set1_ps(0.99997726f), _mm_mul_ps(s, r)));
+        r = select_ps(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(half_pi, r), r);
+        r = select_ps(_mm_cmplt_ps(x, zero), _mm_sub_ps(pi, r), r);
+        r = select_ps(_mm_cmplt_ps(y, zero), _mm_xor_ps(r, sign), r);
+        _mm_storeu_ps(amplitude + n, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y))));
+        _mm_storeu_ps(phase + n, r);
+    }
+    amplitude_phase_scalar(i + n, q + n, amplitude + n, phase + n, count - n);
+}
+#endif
+
+#if defined(XETHRU_KERNELS_AVX2)
+__attribute__((target("avx2")))
+inline void amplitude_phase_avx2(const float *i, const float *q, float *amplitude, float *phase, size_t count)
+{
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 pi = _mm256_set1_ps(3.14159265f);
+    const __m256 half_pi = _mm256_set1_ps(3.14159265f / 2);
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const __m256 x = _mm256_loadu_ps(i + n);
+        const __m256 y = _mm256_loadu_ps(q + n);
+        const __m256 ax = _mm256_andnot_ps(sign, x);
+        const __m256 ay = _mm256_andnot_ps(sign, y);
+        const __m256 max = _mm256_max_ps(ax, ay);
+        const __m256 a = _mm256_and_ps(_mm256_div_ps(_mm256_min_ps(ax, ay), max),
+                                       _mm256_cmp_ps(max, zero, _CMP_GT_OQ));
+        const __m256 s = _mm256_mul_ps(a, a);
+        __m256 r = _mm256_add_ps(_mm256_set1_ps(0.05265332f), _mm256_mul_ps(s, _mm256_set1_ps(-0.01172120f)));
+        r = _mm256_add_ps(_mm256_set1_ps(-0.11643287f), _mm256_mul_ps(s, r));
+        r = _mm256_add_ps(_mm256_set1_ps(0.19354346f), _mm256_mul_ps(s, r));
+        r = _mm256_add_ps(_mm256_set1_ps(-0.33262347f), _mm256_mul_ps(s, r));
+        r = _mm256_mul_ps(a, _mm256_add_ps(_mm256_set1_ps(0.99997726f), _mm256_mul_ps(s, r)));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(half_pi, r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(pi, r), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_xor_ps(r, sign), _mm256_cmp_ps(y, zero, _CMP_LT_OQ));
+        _mm256_storeu_ps(amplitude + n, _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y))));
+        _mm256_storeu_ps(phase + n, r);
+    }
+    amplitude_phase_sse2(i + n, q + n, amplitude + n, phase + n, count - n);
+}
+#endif
+
+typedef void (*AmplitudePhaseFunction)(const float *, const float *, float *, float *, size_t);
+
+inline AmplitudePhaseFunction select_amplitude_phase()
+{
+#if defined(XETHRU_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return &amplitude_phase_avx2;
+#endif
+#if defined(XETHRU_KERNELS_SSE2)
+    return &amplitude_phase_sse2;
+#else
+    return &amplitude_phase_scalar;
+#endif
+}
+
+} // namespace detail
+
+/**
+ * Computes amplitude and phase from split I/Q samples.
+ *
+ * amplitude = sqrt(i^2 + q^2) and phase = atan2(q, i) in radians, range [-pi, pi].
+ * The phase uses a polynomial approximation with an absolute error below 2e-6 radians;
+ * unlike std::atan2 it returns pi rather than -pi for q = -0 and i < 0.
+ * The implementation is selected at runtime like \ref q15_to_float.
+ *
+ * @param i Specifies the in phase values.
+ * @param q Specifies the quadrature phase values.
+ * @param[out] amplitude Specifies where to write \a count amplitude values.
+ * @param[out] phase Specifies where to write \a count phase values.
+ * @param count Specifies the number of samples.
+ */
+inline void iq_to_amplitude_phase(const float *i, const float *q, float *amplitude, float *phase, size_t count)
+{
+    static const detail::AmplitudePhaseFunction convert = detail::select_amplitude_phase();
+    convert(i, q, amplitude, phase, count);
+}
+
+/**
+ * Fills the lookup table used by \ref dequantize_bytes for dB compressed byte data, e.g.
+ * \ref PulseDopplerByteData: table[b] = 10^((b * step_size + step_start) / 10).
+ *
+ * @param step_start Specifies the start of the dB compression range.
+ * @param step_size Specifies the size of one step in dB.
+ * @param[out] table Specifies where to write the 256 table entries.
+ */
+inline void db_byte_table(float step_start, float step_size, float *table)
+{
+    for (int b = 0; b < 256; ++b)
+        table[b] = std::pow(10.0f, (b * step_size + step_start) / 10.0f);
+}
+
+namespace detail {
+
+inline void dequantize_bytes_scalar(const unsigned char *in, float *out, size_t count, const float *table)
+{
+    for (size_t n = 0; n < count; ++n)
+        out[n] = table[in[n]];
+}
+
+#if defined(XETHRU_KERNELS_AVX2)
+__attribute__((target("avx2")))
+inline void dequantize_bytes_avx2(const unsigned char *in, float *out, size_t count, const float *table)
+{
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + n)));
+        _mm256_storeu_ps(out + n, _mm256_i32gather_ps(table, index, 4));
+    }
+    dequantize_bytes_scalar(in + n, out + n, count - n, table);
+}
+#endif
+
+typedef void (*DequantizeBytesFunction)(const unsigned char *, float *, size_t, const float *);
+
+inline DequantizeBytesFunction select_dequantize_bytes()
+{
+#if defined(XETHRU_KERNELS_AVX2)
+    if (__builtin_cpu_supports("avx2"))
+        return &dequantize_bytes_avx2;
+#endif
+    return &dequantize_bytes_scalar;
+}
+
+} // namespace detail
+
+/**
+ * Converts byte data through a 256 entry lookup table, out[n] = table[in[n]].
+ * Uses gather instructions where available.
+ *
+ * @param in Specifies the byte values.
+ * @param[out] out Specifies where to write \a count values.
+ * @param count Specifies the number of values.
+ * @param table Specifies the table, e.g. filled by \ref db_byte_table.
+ */
+inline void dequantize_bytes(const unsigned char *in, float *out, size_t count, const float *table)
+{
+    static const detail::DequantizeBytesFunction convert = detail::select_dequantize_bytes();
+    convert(in, out, count, table);
+}
+
+} // namespace XeThru
+
+#endif // RADARKERNELS_HPP
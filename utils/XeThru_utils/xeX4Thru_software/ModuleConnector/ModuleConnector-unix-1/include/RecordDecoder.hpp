@@ -0,0 +1,539 @@
+#ifndef RECORDDECODER_HPP
+#define RECORDDECODER_HPP
+
+#include "Data.hpp"
+#include "datatypes.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace XeThru {
+
+namespace detail {
+
+// Reads little-endian fields from a record. Any read past the end fails the cursor.
+class RecordCursor
+{
+public:
+    RecordCursor(const uint8_t *data, uint32_t size) : pos(data), end(data + size), ok(true) {}
+
+    template<typename T>
+    void get(T *value)
+    {
+        if (remaining() < sizeof(T)) {
+            ok = false;
+            *value = T();
+            return;
+        }
+        std::memcpy(value, pos, sizeof(T));
+        pos += sizeof(T);
+    }
+
+    // Resizing keeps the capacity of out, so decoding into the same struct again
+    // does not allocate unless a record is larger than any before it.
+    template<typename T>
+    void get(std::vector<T> &out, uint32_t count)
+    {
+        if (!ok || count > remaining() / sizeof(T)) {
+            ok = false;
+            out.clear();
+            return;
+        }
+        out.resize(count);
+        if (count > 0)
+            std::memcpy(out.data(), pos, count * sizeof(T));
+        pos += count * sizeof(T);
+    }
+
+    void skip(size_t size)
+    {
+        if (remaining() < size)
+            ok = false;
+        else
+            pos += size;
+    }
+
+    size_t remaining() const { return static_cast<size_t>(end - pos); }
+
+    // Returns 0 if every field was read and the record has no trailing bytes.
+    int finish() const { return ok && pos == end ? 0 : 1; }
+
+private:
+    const uint8_t *pos;
+    const uint8_t *end;
+    bool ok;
+};
+
+// Reads the fields of a CSV row as recorded for the sensor data types, e.g.
+// "2019-01-24T14:18:08.123+01:00;1234;0;14.5;0.82;8;12.3;4.5". The first field is the time
+// stamp, the rest follow the member order of the struct. Header and comment rows, which do
+// not start with a digit, and any unparsable field fail the cursor.
+class CsvCursor
+{
+public:
+    CsvCursor(const uint8_t *data, uint32_t size) :
+        pos(reinterpret_cast<const char *>(data)), end(pos + size), ok(true), done(false)
+    {
+        while (end > pos && (end[-1] == '\n' || end[-1] == '\r'))
+            --end;
+        if (pos == end || *pos < '0' || *pos > '9')
+            ok = false;
+        skip();
+    }
+
+    template<typename T>
+    void get(T *value)
+    {
+        char field[64];
+        if (!next(field, sizeof(field)) || !parse(field, value)) {
+            ok = false;
+            *value = T();
+        }
+    }
+
+    // Resizing keeps the capacity of out, as with RecordCursor.
+    template<typename T>
+    void get(std::vector<T> &out, uint32_t count)
+    {
+        if (!ok || count > static_cast<size_t>(end - pos)) {
+            ok = false;
+            out.clear();
+            return;
+        }
+        out.resize(count);
+        for (uint32_t n = 0; n < count; ++n)
+            get(&out[n]);
+    }
+
+    void skip()
+    {
+        char field[64];
+        next(field, sizeof(field));
+    }
+
+    // Returns 0 if every field was read and the row has no further fields.
+    int finish() const { return ok && done ? 0 : 1; }
+
+private:
+    // Copies the next field to field, as a terminated string.
+    bool next(char *field, size_t field_size)
+    {
+        if (!ok || done) {
+            ok = false;
+            return false;
+        }
+        const char *separator = static_cast<const char *>(std::memchr(pos, ';', static_cast<size_t>(end - pos)));
+        if (!separator) {
+            separator = end;
+            done = true;
+        }
+        const size_t length = static_cast<size_t>(separator - pos);
+        if (length == 0 || length >= field_size) {
+            ok = false;
+            return false;
+        }
+        std::memcpy(field, pos, length);
+        field[length] = '\0';
+        pos = done ? end : separator + 1;
+        return true;
+    }
+
+    static bool parse(const char *field, float *value)
+    {
+        char *parsed;
+        *value = std::strtof(field, &parsed);
+        return *parsed == '\0';
+    }
+
+    static bool parse(const char *field, uint32_t *value)
+    {
+        char *parsed;
+        const unsigned long long result = std::strtoull(field, &parsed, 10);
+        *value = static_cast<uint32_t>(result);
+        return *parsed == '\0' && field[0] != '-' && result <= 0xffffffffULL;
+    }
+
+    static bool parse(const char *field, uint8_t *value)
+    {
+        uint32_t result;
+        if (!parse(field, &result) || result > 0xff)
+            return false;
+        *value = static_cast<uint8_t>(result);
+        return true;
+    }
+
+    const char *pos;
+    const char *end;
+    bool ok;
+    bool done;
+};
+
+// Data types each decoder accepts.
+template<typename T> struct record_data_types;
+template<> struct record_data_types<BasebandApData> { static const uint32_t value = BasebandApDataType; };
+template<> struct record_data_types<BasebandIqData> { static const uint32_t value = BasebandIqDataType; };
+template<> struct record_data_types<SleepData> { static const uint32_t value = SleepDataType; };
+template<> struct record_data_types<RespirationData> { static const uint32_t value = RespirationDataType; };
+template<> struct record_data_types<std::string> { static const uint32_t value = StringDataType; };
+template<> struct record_data_types<PulseDopplerFloatData>
+{
+    static const uint32_t value = PulseDopplerFloatDataType | NoiseMapFloatDataType;
+};
+template<> struct record_data_types<PulseDopplerByteData>
+{
+    static const uint32_t value = PulseDopplerByteDataType | NoiseMapByteDataType;
+};
+template<> struct record_data_types<DataFloat> { static const uint32_t value = FloatDataType; };
+template<> struct record_data_types<PresenceSingleData> { static const uint32_t value = PresenceSingleDataType; };
+template<> struct record_data_types<PresenceMovingListData> { static const uint32_t value = PresenceMovingListDataType; };
+template<> struct record_data_types<RespirationDetectionListData>
+{
+    static const uint32_t value = RespirationDetectionListDataType;
+};
+template<> struct record_data_types<RespirationMovingListData>
+{
+    static const uint32_t value = RespirationMovingListDataType;
+};
+template<> struct record_data_types<VitalSignsData> { static const uint32_t value = VitalSignsDataType; };
+template<> struct record_data_types<SleepStageData> { static const uint32_t value = SleepStageDataType; };
+template<> struct record_data_types<RespirationNormalizedMovementListData>
+{
+    static const uint32_t value = RespirationNormalizedMovementListDataType;
+};
+template<> struct record_data_types<RadarRfData> { static const uint32_t value = RadarRfDataType; };
+template<> struct record_data_types<RadarRfNormalizedData> { static const uint32_t value = RadarRfNormalizedDataType; };
+template<> struct record_data_types<RadarBasebandFloatData> { static const uint32_t value = RadarBasebandFloatDataType; };
+template<> struct record_data_types<RadarBasebandQ15Data> { static const uint32_t value = RadarBasebandQ15DataType; };
+
+} // namespace detail
+
+/**
+ * @defgroup RecordDecoders Record decoders
+ *
+ * Decode the bytes of a recorded \ref DataRecord into the matching Data.hpp struct.
+ *
+ * The fields of a binary record are stored in the order of the members of the struct,
+ * little-endian, with each array preceded by its element count unless the struct already
+ * holds the count (e.g. BasebandIqData::num_bins).
+ *
+ * SleepData, RespirationData, VitalSignsData, PresenceSingleData and PresenceMovingListData
+ * are recorded as CSV text instead: one ';' separated row per record, starting with a time
+ * stamp column followed by the fields in the same order, with the same element counts
+ * before each list. Their decoders parse that row; the time stamp is skipped, see
+ * \ref DataRecord::epoch. The CSV header row (\ref DataRecord::is_csv_header) is not
+ * decoded. The decoders write into a struct
+ * provided by the caller and resize its vectors in place, so decoding a stream of records
+ * into the same struct does not allocate once the vectors have reached their largest size.
+ *
+ * Each decoder returns 0 on success, or 1 if the record is too short, has trailing bytes,
+ * or, for the \ref DataRecord and \ref RecordView overloads, is a user header or of a data
+ * type the struct does not hold. Noise map records decode into PulseDopplerFloatData and
+ * PulseDopplerByteData. ByteDataType has no struct in Data.hpp and is not decoded.
+ *
+ * @code
+ * BasebandIqData iq;
+ * while (!reader.at_end()) {
+ *     reader.read_record(&record);
+ *     if (decode_record(record, &iq) == 0)
+ *         process(iq);
+ * }
+ * @endcode
+ *
+ * @{
+ */
+
+inline int decode_record(const uint8_t *data, uint32_t size, BasebandApData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->range_offset);
+    cursor.get(out->amplitude, out->num_bins);
+    cursor.get(out->phase, out->num_bins);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, BasebandIqData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->range_offset);
+    cursor.get(out->i_data, out->num_bins);
+    cursor.get(out->q_data, out->num_bins);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, SleepData *out)
+{
+    detail::CsvCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->sensor_state);
+    cursor.get(&out->respiration_rate);
+    cursor.get(&out->distance);
+    cursor.get(&out->signal_quality);
+    cursor.get(&out->movement_slow);
+    cursor.get(&out->movement_fast);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RespirationData *out)
+{
+    detail::CsvCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->sensor_state);
+    cursor.get(&out->respiration_rate);
+    cursor.get(&out->distance);
+    cursor.get(&out->movement);
+    cursor.get(&out->signal_quality);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, std::string *out)
+{
+    out->assign(reinterpret_cast<const char *>(data), size);
+    return 0;
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, PulseDopplerFloatData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->matrix_counter);
+    cursor.get(&out->range_idx);
+    cursor.get(&out->range_bins);
+    cursor.get(&out->frequency_count);
+    cursor.get(&out->pulsedoppler_instance);
+    cursor.get(&out->fps);
+    cursor.get(&out->fps_decimated);
+    cursor.get(&out->frequency_start);
+    cursor.get(&out->frequency_step);
+    cursor.get(&out->range);
+    cursor.get(out->data, out->frequency_count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, PulseDopplerByteData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->matrix_counter);
+    cursor.get(&out->range_idx);
+    cursor.get(&out->range_bins);
+    cursor.get(&out->frequency_count);
+    cursor.get(&out->pulsedoppler_instance);
+    cursor.get(&out->byte_step_start);
+    cursor.get(&out->byte_step_size);
+    cursor.get(&out->fps);
+    cursor.get(&out->fps_decimated);
+    cursor.get(&out->frequency_start);
+    cursor.get(&out->frequency_step);
+    cursor.get(&out->range);
+    cursor.get(out->data, out->frequency_count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, DataFloat *out)
+{
+    detail::RecordCursor cursor(data, size);
+    uint32_t count;
+    cursor.get(&out->content_id);
+    cursor.get(&out->info);
+    cursor.get(&count);
+    cursor.get(out->data, count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, PresenceSingleData *out)
+{
+    detail::CsvCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->presence_state);
+    cursor.get(&out->distance);
+    cursor.get(&out->direction);
+    cursor.get(&out->signal_quality);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, PresenceMovingListData *out)
+{
+    detail::CsvCursor cursor(data, size);
+    uint32_t interval_count;
+    uint32_t detection_count;
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->presence_state);
+    cursor.get(&interval_count);
+    cursor.get(out->movement_slow_items, interval_count);
+    cursor.get(out->movement_fast_items, interval_count);
+    cursor.get(&detection_count);
+    cursor.get(out->detection_distance_items, detection_count);
+    cursor.get(out->radar_cross_section_items, detection_count);
+    cursor.get(out->detection_velocity_items, detection_count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RespirationDetectionListData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->counter);
+    cursor.get(&out->detection_count);
+    cursor.get(out->detection_distance_items, out->detection_count);
+    cursor.get(out->detection_radar_cross_section_items, out->detection_count);
+    cursor.get(out->detection_velocity_items, out->detection_count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RespirationMovingListData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    uint32_t interval_count;
+    cursor.get(&out->counter);
+    cursor.get(&interval_count);
+    cursor.get(out->movement_slow_items, interval_count);
+    cursor.get(out->movement_fast_items, interval_count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, VitalSignsData *out)
+{
+    detail::CsvCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->sensor_state);
+    cursor.get(&out->respiration_rate);
+    cursor.get(&out->respiration_distance);
+    cursor.get(&out->respiration_confidence);
+    cursor.get(&out->heart_rate);
+    cursor.get(&out->heart_distance);
+    cursor.get(&out->heart_confidence);
+    cursor.get(&out->normalized_movement_slow);
+    cursor.get(&out->normalized_movement_fast);
+    cursor.get(&out->normalized_movement_start);
+    cursor.get(&out->normalized_movement_end);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, SleepStageData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->sleepstage);
+    cursor.get(&out->confidence);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RespirationNormalizedMovementListData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->start);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->count);
+    cursor.get(out->normalized_movement_slow_items, out->count);
+    cursor.get(out->normalized_movement_fast_items, out->count);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RadarRfData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->frames_per_second);
+    cursor.get(&out->range_offset);
+    cursor.get(out->data, out->num_bins);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RadarRfNormalizedData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->frames_per_second);
+    cursor.get(&out->range_offset);
+    cursor.get(out->data, out->num_bins);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RadarBasebandFloatData *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->frames_per_second);
+    cursor.get(&out->range_offset);
+    cursor.get(&out->decimation_factor);
+    cursor.get(&out->correction_bin);
+    cursor.get(&out->correction_i);
+    cursor.get(&out->correction_q);
+    cursor.get(out->i_data, out->num_bins);
+    cursor.get(out->q_data, out->num_bins);
+    return cursor.finish();
+}
+
+inline int decode_record(const uint8_t *data, uint32_t size, RadarBasebandQ15Data *out)
+{
+    detail::RecordCursor cursor(data, size);
+    cursor.get(&out->frame_counter);
+    cursor.get(&out->num_bins);
+    cursor.get(&out->bin_length);
+    cursor.get(&out->sample_frequency);
+    cursor.get(&out->carrier_frequency);
+    cursor.get(&out->frames_per_second);
+    cursor.get(&out->range_offset);
+    cursor.get(&out->decimation_factor);
+    cursor.get(&out->correction_bin);
+    cursor.get(&out->correction_i);
+    cursor.get(&out->correction_q);
+    cursor.get(&out->scaling_factor);
+    cursor.get(out->i_data, out->num_bins);
+    cursor.get(out->q_data, out->num_bins);
+    return cursor.finish();
+}
+
+/**
+ * Decodes \a record into \a out if it holds the data type of \a out.
+ * @return 0 on success, otherwise returns 1
+ */
+template<typename T>
+int decode_record(const DataRecord &record, T *out)
+{
+    if (!record.is_valid || record.is_user_header || !(record.data_type & detail::record_data_types<T>::value))
+        return 1;
+    return decode_record(record.data.data(), static_cast<uint32_t>(record.data.size()), out);
+}
+
+/**
+ * Decodes \a record into \a out if it holds the data type of \a out.
+ * @return 0 on success, otherwise returns 1
+ */
+template<typename T>
+int decode_record(const RecordView &record, T *out)
+{
+    if (!record.data || record.is_user_header || !(record.data_type & detail::record_data_types<T>::value))
+        return 1;
+    return decode_record(record.data, record.size, out);
+}
+
+/** @} */
+
+} // namespace XeThru
+
+#endif // RECORDDECODER_HPP
@@ -0,0 +1,730 @@
+#ifndef RECORDINGINDEX_HPP
+#define RECORDINGINDEX_HPP
+
+#include "DataReader.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+namespace XeThru {
+
+namespace detail {
+
+// Size and modification time identify the version of a meta file.
+inline bool file_stamp(const std::string &filename, uint64_t *size, int64_t *mtime)
+{
+    struct stat st;
+    if (::stat(filename.c_str(), &st) != 0)
+        return false;
+    *size = static_cast<uint64_t>(st.st_size);
+    *mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+}
+
+inline bool write_all(std::FILE *file, const void *data, size_t size)
+{
+    return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+// Writes a file through a temporary file, so that readers never see a partial file.
+inline bool replace_file(const std::string &temp_filename, const std::string &filename)
+{
+    if (std::rename(temp_filename.c_str(), filename.c_str()) == 0)
+        return true;
+    // rename does not replace an existing file on Windows.
+    std::remove(filename.c_str());
+    if (std::rename(temp_filename.c_str(), filename.c_str()) == 0)
+        return true;
+    std::remove(temp_filename.c_str());
+    return false;
+}
+
+static const uint32_t no_data_file = 0xffffffff;
+
+// One record of a recording. position is the byte position of the record as used by
+// DataReader::seek_byte; file and offset locate the record bytes in the data files of
+// the recording, file is no_data_file if they could not be located.
+struct RecordIndexEntry
+{
+    int64_t epoch;
+    uint64_t position;
+    uint64_t offset;
+    uint32_t size;
+    uint32_t data_type;
+    uint32_t file;
+    uint32_t is_user_header;
+};
+
+// Header of an index file. It is followed by the data files, each as its size (uint64),
+// name length (uint32) and name relative to the folder of the meta file, and then by the
+// entries.
+struct RecordingIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    uint64_t record_count;
+    uint64_t meta_size;
+    int64_t meta_mtime;
+    int64_t start_epoch;
+    int64_t duration;
+    int64_t size;
+    uint32_t data_types;
+    uint32_t max_record_size;
+    uint32_t meta_version;
+    int32_t depth;
+    uint32_t exact_positions;
+    uint32_t file_count;
+};
+
+static const char recording_index_magic[8] = { 'X', 'T', 'R', 'E', 'C', 'I', 'D', 'X' };
+static const uint32_t recording_index_version = 2;
+
+inline std::string directory_of(const std::string &filename)
+{
+    const size_t separator = filename.find_last_of("/\\");
+    return separator == std::string::npos ? std::string(".") : filename.substr(0, separator);
+}
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+
+// Locates records in the data files of a recording by comparing their bytes.
+//
+// The files in the folder of the meta file and below are candidates. The records of a
+// data type follow each other in a file, so each record is first looked for right after
+// the previous record of its type, and otherwise at the start of a file not claimed yet,
+// in the order of the file names. A user header starts a file but may be the same in
+// every file, so user headers are held back until the first record after them selects
+// the file.
+class DataFileLocator
+{
+public:
+    explicit DataFileLocator(const std::string &meta_filename) : ok(true)
+    {
+        root = directory_of(meta_filename);
+        list(root, std::string(), meta_filename);
+        std::sort(files.begin(), files.end(),
+            [](const Candidate &a, const Candidate &b) { return a.name < b.name; });
+        for (int n = 0; n < 32; ++n) {
+            cursors[n].file = no_data_file;
+            cursors[n].offset = 0;
+        }
+    }
+
+    ~DataFileLocator()
+    {
+        for (size_t n = 0; n < files.size(); ++n) {
+            if (files[n].fd >= 0)
+                ::close(files[n].fd);
+        }
+    }
+
+    // Locates the record of entries[index]. Entries of held back user headers are
+    // updated when their file is found.
+    void locate(std::vector<RecordIndexEntry> &entries, size_t index, const uint8_t *data)
+    {
+        RecordIndexEntry &entry = entries[index];
+        entry.file = no_data_file;
+        entry.offset = 0;
+        if (!ok)
+            return;
+        Cursor &cursor = cursors[data_type_index(entry.data_type)];
+        Pending &pending = held_back[data_type_index(entry.data_type)];
+        if (entry.is_user_header) {
+            pending.entries.push_back(index);
+            pending.bytes.insert(pending.bytes.end(), data, data + entry.size);
+            cursor.file = no_data_file;
+            return;
+        }
+        if (pending.entries.empty() && cursor.file != no_data_file &&
+            matches(cursor.file, cursor.offset, data, entry.size)) {
+            entry.file = cursor.file;
+            entry.offset = cursor.offset;
+            cursor.offset += entry.size;
+            return;
+        }
+        for (uint32_t n = 0; n < files.size(); ++n) {
+            if (files[n].claimed ||
+                !matches(n, 0, pending.bytes.data(), pending.bytes.size()) ||
+                !matches(n, pending.bytes.size(), data, entry.size))
+                continue;
+            files[n].claimed = true;
+            uint64_t offset = 0;
+            for (size_t p = 0; p < pending.entries.size(); ++p) {
+                entries[pending.entries[p]].file = n;
+                entries[pending.entries[p]].offset = offset;
+                offset += entries[pending.entries[p]].size;
+            }
+            entry.file = n;
+            entry.offset = offset;
+            cursor.file = n;
+            cursor.offset = offset + entry.size;
+            pending.entries.clear();
+            pending.bytes.clear();
+            return;
+        }
+        ok = false;
+    }
+
+    // Locates the user headers still held back, i.e. of files without records.
+    bool finish(std::vector<RecordIndexEntry> &entries)
+    {
+        for (int type = 0; ok && type < 32; ++type) {
+            Pending &pending = held_back[type];
+            size_t first = 0;
+            while (ok && first < pending.entries.size()) {
+                // Consecutive headers of one type are in separate files.
+                RecordIndexEntry &entry = entries[pending.entries[first]];
+                const uint8_t *data = pending.bytes.data();
+                for (size_t p = 0; p < first; ++p)
+                    data += entries[pending.entries[p]].size;
+                ok = false;
+                for (uint32_t n = 0; n < files.size(); ++n) {
+                    if (!files[n].claimed && matches(n, 0, data, entry.size)) {
+                        files[n].claimed = true;
+                        entry.file = n;
+                        entry.offset = 0;
+                        ok = true;
+                        break;
+                    }
+                }
+                ++first;
+            }
+        }
+        return ok;
+    }
+
+    bool is_ok() const { return ok; }
+
+    // Returns the name, relative to the folder of the meta file, and the size of the
+    // claimed files, renumbering the entries to match.
+    void claimed_files(std::vector<RecordIndexEntry> &entries, std::vector<std::string> *names,
+                       std::vector<uint64_t> *sizes) const
+    {
+        std::vector<uint32_t> number(files.size(), no_data_file);
+        for (size_t n = 0; n < files.size(); ++n) {
+            if (files[n].claimed) {
+                number[n] = static_cast<uint32_t>(names->size());
+                names->push_back(files[n].name);
+                sizes->push_back(files[n].size);
+            }
+        }
+        for (size_t n = 0; n < entries.size(); ++n) {
+            if (entries[n].file != no_data_file)
+                entries[n].file = number[entries[n].file];
+        }
+    }
+
+private:
+    DataFileLocator(const DataFileLocator &other) = delete;
+    DataFileLocator& operator= (const DataFileLocator &other) = delete;
+
+    struct Candidate
+    {
+        std::string name;
+        uint64_t size;
+        int fd;
+        bool claimed;
+    };
+
+    struct Cursor
+    {
+        uint32_t file;
+        uint64_t offset;
+    };
+
+    struct Pending
+    {
+        std::vector<size_t> entries;
+        std::vector<uint8_t> bytes;
+    };
+
+    static bool ends_with(const std::string &name, const char *suffix)
+    {
+        const size_t length = std::strlen(suffix);
+        return name.size() >= length && name.compare(name.size() - length, length, suffix) == 0;
+    }
+
+    void list(const std::string &directory, const std::string &prefix, const std::string &meta_filename)
+    {
+        DIR *dir = ::opendir(directory.c_str());
+        if (!dir)
+            return;
+        while (struct dirent *item = ::readdir(dir)) {
+            const std::string name = item->d_name;
+            if (name == "." || name == "..")
+                continue;
+            const std::string path = directory + "/" + name;
+            struct stat st;
+            if (::stat(path.c_str(), &st) != 0)
+                continue;
+            if (S_ISDIR(st.st_mode)) {
+                list(path, prefix + name + "/", meta_filename);
+            } else if (S_ISREG(st.st_mode) && st.st_size > 0 && name != "xethru_recording_meta.dat" &&
+                       path != meta_filename && !ends_with(name, ".index") && !ends_with(name, ".tmp")) {
+                Candidate candidate;
+                candidate.name = prefix + name;
+                candidate.size = static_cast<uint64_t>(st.st_size);
+                candidate.fd = -1;
+                candidate.claimed = false;
+                files.push_back(candidate);
+            }
+        }
+        ::closedir(dir);
+    }
+
+    bool matches(uint32_t file, uint64_t offset, const uint8_t *data, size_t size)
+    {
+        Candidate &candidate = files[file];
+        if (offset > candidate.size || size > candidate.size - offset)
+            return false;
+        if (size == 0)
+            return true;
+        if (candidate.fd < 0) {
+            candidate.fd = ::open((root + "/" + candidate.name).c_str(), O_RDONLY | O_CLOEXEC);
+            if (candidate.fd < 0)
+                return false;
+        }
+        if (scratch.size() < size)
+            scratch.resize(size);
+        size_t done = 0;
+        while (done < size) {
+            const ssize_t count = ::pread(candidate.fd, scratch.data() + done, size - done,
+                                          static_cast<off_t>(offset + done));
+            if (count <= 0)
+                return false;
+            done += static_cast<size_t>(count);
+        }
+        return std::memcmp(scratch.data(), data, size) == 0;
+    }
+
+    std::string root;
+    std::vector<Candidate> files;
+    Cursor cursors[32];
+    Pending held_back[32];
+    std::vector<uint8_t> scratch;
+    bool ok;
+};
+
+#endif // !_WIN32
+
+} // namespace detail
+
+/**
+ * @class RecordingIndex
+ *
+ * Persistent per-record index of a recording, used to seek a \ref DataReader without
+ * scanning and by \ref MappedDataReader to map the records.
+ *
+ * The index holds the epoch, byte position, data type and size of every record and,
+ * where they can be located, the data file and offset holding the record. It is built by
+ * reading the recording once and saved next to the meta file
+ * (*xethru_recording_meta.dat.index*). Later opens load the saved index, unless the size
+ * or modification time of the meta file changed or a data file shrank, in which case it
+ * is built again.
+ *
+ * \ref seek_ms finds the record by binary search and moves the reader there with
+ * \ref DataReader::seek_byte, so scrubbing through a long recording costs the same as
+ * seeking near its start. The epochs are wall clock times, which go backwards when the
+ * clock is stepped while recording, e.g. by NTP on a device without a real-time clock. The
+ * binary search then cannot be used, see \ref has_sorted_epochs, and \ref seek_ms falls
+ * back to \ref DataReader::seek_ms.
+ *
+ * The data files are located by comparing the records with the files in the folder of
+ * the meta file and its subfolders. When a record cannot be located, e.g. for a chained
+ * recording in another folder, \ref has_data_files returns false; seeking still works.
+ * Data files are not located on Windows.
+ *
+ * @code
+ * DataReader reader;
+ * RecordingIndex index;
+ * reader.open(meta_filename);
+ * index.open(meta_filename);
+ * index.seek_ms(reader, 3600 * 1000); // one hour into the recording
+ * @endcode
+ *
+ * @see DataReader, MappedDataReader
+ */
+class RecordingIndex
+{
+public:
+    /**
+     * Constructs an empty index.
+     */
+    RecordingIndex() : start_epoch(0), duration(0), recording_size(0), data_types(0),
+        max_record_size(0), meta_version(0), exact_positions(false), sorted_epochs(false), loaded(false) {}
+
+    /**
+     * Loads the index of a recording, building and saving it first if it is missing or
+     * out of date.
+     * @param meta_filename Specifies which recording (*xethru_recording_meta.dat*) to index
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, int depth = -1)
+    {
+        return open(meta_filename, depth, meta_filename + ".index");
+    }
+
+    /**
+     * Loads the index of a recording using the given index filename, e.g. when the
+     * recording folder is not writable.
+     * @param meta_filename Specifies which recording (*xethru_recording_meta.dat*) to index
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @param index_filename Specifies where to read or write the index.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, int depth, const std::string &index_filename)
+    {
+        close();
+        uint64_t meta_size;
+        int64_t meta_mtime;
+        if (!detail::file_stamp(meta_filename, &meta_size, &meta_mtime))
+            return 1;
+        const std::string directory = detail::directory_of(meta_filename);
+        if (load(index_filename, directory, meta_size, meta_mtime, depth))
+            return 0;
+        if (!build(meta_filename, depth))
+            return 1;
+        // Failing to save only costs a rebuild on the next open.
+        save(index_filename, meta_size, meta_mtime, depth);
+        for (size_t n = 0; n < files.size(); ++n)
+            files[n] = directory + "/" + files[n];
+        return 0;
+    }
+
+    /**
+     * @return true if the index is loaded, otherwise returns false
+     */
+    bool is_open() const { return loaded; }
+
+    /**
+     * Releases the index.
+     */
+    void close()
+    {
+        std::vector<detail::RecordIndexEntry>().swap(entries);
+        std::vector<std::string>().swap(files);
+        std::vector<uint64_t>().swap(file_sizes);
+        start_epoch = 0;
+        duration = 0;
+        recording_size = 0;
+        data_types = 0;
+        max_record_size = 0;
+        meta_version = 0;
+        exact_positions = false;
+        sorted_epochs = false;
+        loaded = false;
+    }
+
+    /**
+     * @return the number of records in the recording.
+     */
+    size_t size() const { return entries.size(); }
+
+    /**
+     * @return the entry of a record, by its index in the recording.
+     */
+    const detail::RecordIndexEntry &entry(size_t index) const { return entries[index]; }
+
+    /**
+     * @return true if every record was located in the data files, see \ref get_data_files.
+     */
+    bool has_data_files() const
+    {
+        return loaded && (entries.empty() || !files.empty()) &&
+            std::find_if(entries.begin(), entries.end(), [](const detail::RecordIndexEntry &e) {
+                return e.file == detail::no_data_file; }) == entries.end();
+    }
+
+    /**
+     * @return the paths of the data files holding the records, as referred to by the entries.
+     */
+    const std::vector<std::string> &get_data_files() const { return files; }
+
+    /**
+     * @return the sizes of the data files when the index was built.
+     */
+    const std::vector<uint64_t> &get_data_file_sizes() const { return file_sizes; }
+
+    /**
+     * @return true if the epochs of the records never decrease, so that positions in
+     * milliseconds are found by binary search, otherwise returns false.
+     */
+    bool has_sorted_epochs() const { return sorted_epochs; }
+
+    /**
+     * Finds the first record written at or after the given position. Without sorted
+     * epochs, see \ref has_sorted_epochs, the records are scanned in order.
+     * @param position Specifies the position as number of milliseconds.
+     * @return the byte position of the record, the size of the recording if there is no
+     * such record, or -1 if the position is negative.
+     */
+    int64_t byte_position_ms(int64_t position) const
+    {
+        if (position < 0)
+            return -1;
+        const size_t index = record_index_ms(position);
+        if (index == entries.size())
+            return entries.empty() ? 0 : entries.back().position + entries.back().size;
+        return entries[index].position;
+    }
+
+    /**
+     * @return the index of the first record written at or after the given position. Without
+     * sorted epochs, see \ref has_sorted_epochs, the records are scanned in order.
+     */
+    size_t record_index_ms(int64_t position) const
+    {
+        const int64_t epoch = start_epoch + position;
+        if (!sorted_epochs) {
+            return std::find_if(entries.begin(), entries.end(),
+                [epoch](const detail::RecordIndexEntry &entry) { return entry.epoch >= epoch; }) -
+                entries.begin();
+        }
+        return std::lower_bound(entries.begin(), entries.end(), epoch,
+            [](const detail::RecordIndexEntry &entry, int64_t value) { return entry.epoch < value; }) -
+            entries.begin();
+    }
+
+    /**
+     * @return the index of the first record at or after the given byte position.
+     */
+    size_t record_index_byte(int64_t position) const
+    {
+        return std::lower_bound(entries.begin(), entries.end(), static_cast<uint64_t>(position),
+            [](const detail::RecordIndexEntry &entry, uint64_t value) { return entry.position < value; }) -
+            entries.begin();
+    }
+
+    /**
+     * Sets the current position of \a reader, like \ref DataReader::seek_ms but without
+     * scanning the recording.
+     * @param reader Specifies a reader with the indexed recording open.
+     * @param position Specifies the position as number of milliseconds.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_ms(DataReader &reader, int64_t position) const
+    {
+        if (!loaded || !exact_positions || !sorted_epochs)
+            return reader.seek_ms(position);
+        const int64_t byte_position = byte_position_ms(position);
+        if (byte_position < 0)
+            return 1;
+        return reader.seek_byte(byte_position);
+    }
+
+    /**
+     * Sets the current position of \a reader to the first record at or after the given
+     * byte position, so that the next read starts on a record boundary.
+     * @param reader Specifies a reader with the indexed recording open.
+     * @param position Specifies the position as number of bytes.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_byte(DataReader &reader, int64_t position) const
+    {
+        if (!loaded || !exact_positions || position < 0)
+            return reader.seek_byte(position);
+        const size_t index = record_index_byte(position);
+        return reader.seek_byte(index == entries.size() ? position : static_cast<int64_t>(entries[index].position));
+    }
+
+    int64_t get_start_epoch() const { return start_epoch; }
+    int64_t get_duration() const { return duration; }
+    int64_t get_size() const { return recording_size; }
+    uint32_t get_data_types() const { return data_types; }
+    uint32_t get_max_record_size() const { return max_record_size; }
+    uint32_t get_meta_version() const { return meta_version; }
+
+private:
+    RecordingIndex(const RecordingIndex &other) = delete;
+    RecordingIndex& operator= (const RecordingIndex &other) = delete;
+
+    bool build(const std::string &meta_filename, int depth)
+    {
+        DataReader reader;
+        if (reader.open(meta_filename, depth) != 0)
+            return false;
+        const uint32_t max_size = std::max<uint32_t>(reader.get_max_record_size(), 1);
+        std::unique_ptr<uint8_t[]> buffer(new uint8_t[max_size]);
+#if !defined(_WIN32) && !defined(__MINGW32__)
+        detail::DataFileLocator locator(meta_filename);
+#endif // !_WIN32
+        uint64_t position = 0;
+        while (!reader.at_end()) {
+            uint32_t size;
+            uint32_t data_type;
+            int64_t epoch;
+            uint8_t is_user_header;
+            if (reader.read_record(buffer.get(), max_size, &size, &data_type, &epoch, &is_user_header) != 0) {
+                close();
+                return false;
+            }
+            detail::RecordIndexEntry entry;
+            entry.epoch = epoch;
+            entry.position = position;
+            entry.offset = 0;
+            entry.size = size;
+            entry.data_type = data_type;
+            entry.file = detail::no_data_file;
+            entry.is_user_header = is_user_header ? 1 : 0;
+            entries.push_back(entry);
+#if !defined(_WIN32) && !defined(__MINGW32__)
+            locator.locate(entries, entries.size() - 1, buffer.get());
+#endif // !_WIN32
+            position += size;
+        }
+#if !defined(_WIN32) && !defined(__MINGW32__)
+        if (locator.finish(entries)) {
+            locator.claimed_files(entries, &files, &file_sizes);
+        } else {
+            for (size_t n = 0; n < entries.size(); ++n)
+                entries[n].file = detail::no_data_file;
+        }
+#endif // !_WIN32
+        start_epoch = reader.get_start_epoch();
+        duration = reader.get_duration();
+        recording_size = reader.get_size();
+        data_types = reader.get_data_types();
+        max_record_size = reader.get_max_record_size();
+        meta_version = reader.get_meta_version();
+        // Positions add up record sizes; only use them for seek_byte if they cover the
+        // recording exactly.
+        exact_positions = static_cast<int64_t>(position) == recording_size;
+        sorted_epochs = epochs_sorted(entries);
+        loaded = true;
+        return true;
+    }
+
+    static bool epochs_sorted(const std::vector<detail::RecordIndexEntry> &entries)
+    {
+        return std::adjacent_find(entries.begin(), entries.end(),
+            [](const detail::RecordIndexEntry &a, const detail::RecordIndexEntry &b) { return b.epoch < a.epoch; }) ==
+            entries.end();
+    }
+
+    bool load(const std::string &index_filename, const std::string &directory, uint64_t meta_size,
+              int64_t meta_mtime, int depth)
+    {
+        std::FILE *file = std::fopen(index_filename.c_str(), "rb");
+        if (!file)
+            return false;
+        detail::RecordingIndexHeader header;
+        bool ok = std::fread(&header, sizeof(header), 1, file) == 1 &&
+            std::memcmp(header.magic, detail::recording_index_magic, sizeof(header.magic)) == 0 &&
+            header.version == detail::recording_index_version &&
+            header.entry_size == sizeof(detail::RecordIndexEntry) &&
+            header.meta_size == meta_size && header.meta_mtime == meta_mtime && header.depth == depth;
+        for (uint32_t n = 0; ok && n < header.file_count; ++n) {
+            uint64_t file_size;
+            uint32_t length;
+            ok = std::fread(&file_size, sizeof(file_size), 1, file) == 1 &&
+                std::fread(&length, sizeof(length), 1, file) == 1 && length < 4096;
+            std::string name(ok ? length : 0, '\0');
+            ok = ok && (length == 0 || std::fread(&name[0], 1, length, file) == length);
+            // A data file that shrank was replaced; its offsets are stale.
+            uint64_t current_size;
+            int64_t mtime;
+            const std::string path = directory + "/" + name;
+            ok = ok && detail::file_stamp(path, &current_size, &mtime) && current_size >= file_size;
+            files.push_back(path);
+            file_sizes.push_back(file_size);
+        }
+        if (ok) {
+            entries.resize(header.record_count);
+            ok = header.record_count == 0 ||
+                std::fread(entries.data(), sizeof(detail::RecordIndexEntry), entries.size(), file) == entries.size();
+        }
+        for (size_t n = 0; ok && n < entries.size(); ++n) {
+            const detail::RecordIndexEntry &entry = entries[n];
+            ok = entry.file == detail::no_data_file ||
+                (entry.file < file_sizes.size() && entry.offset <= file_sizes[entry.file] &&
+                 entry.size <= file_sizes[entry.file] - entry.offset);
+        }
+        std::fclose(file);
+        if (!ok) {
+            close();
+            return false;
+        }
+        start_epoch = header.start_epoch;
+        duration = header.duration;
+        recording_size = header.size;
+        data_types = header.data_types;
+        max_record_size = header.max_record_size;
+        meta_version = header.meta_version;
+        exact_positions = header.exact_positions != 0;
+        sorted_epochs = epochs_sorted(entries);
+        loaded = true;
+        return true;
+    }
+
+    // Called before the file names are made absolute.
+    bool save(const std::string &index_filename, uint64_t meta_size, int64_t meta_mtime, int depth) const
+    {
+        detail::RecordingIndexHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, detail::recording_index_magic, sizeof(header.magic));
+        header.version = detail::recording_index_version;
+        header.entry_size = sizeof(detail::RecordIndexEntry);
+        header.record_count = entries.size();
+        header.meta_size = meta_size;
+        header.meta_mtime = meta_mtime;
+        header.start_epoch = start_epoch;
+        header.duration = duration;
+        header.size = recording_size;
+        header.data_types = data_types;
+        header.max_record_size = max_record_size;
+        header.meta_version = meta_version;
+        header.depth = depth;
+        header.exact_positions = exact_positions ? 1 : 0;
+        header.file_count = static_cast<uint32_t>(files.size());
+
+        const std::string temp_filename = index_filename + ".tmp";
+        std::FILE *file = std::fopen(temp_filename.c_str(), "wb");
+        if (!file)
+            return false;
+        bool ok = detail::write_all(file, &header, sizeof(header));
+        for (size_t n = 0; ok && n < files.size(); ++n) {
+            const uint32_t length = static_cast<uint32_t>(files[n].size());
+            ok = detail::write_all(file, &file_sizes[n], sizeof(file_sizes[n])) &&
+                detail::write_all(file, &length, sizeof(length)) &&
+                detail::write_all(file, files[n].data(), length);
+        }
+        ok = ok && detail::write_all(file, entries.data(), entries.size() * sizeof(detail::RecordIndexEntry));
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) {
+            std::remove(temp_filename.c_str());
+            return false;
+        }
+        return detail::replace_file(temp_filename, index_filename);
+    }
+
+    std::vector<detail::RecordIndexEntry> entries;
+    std::vector<std::string> files;
+    std::vector<uint64_t> file_sizes;
+    int64_t start_epoch;
+    int64_t duration;
+    int64_t recording_size;
+    uint32_t data_types;
+    uint32_t max_record_size;
+    uint32_t meta_version;
+    bool exact_positions;
+    bool sorted_epochs;
+    bool loaded;
+};
+
+} // namespace XeThru
+
+#endif // RECORDINGINDEX_HPP
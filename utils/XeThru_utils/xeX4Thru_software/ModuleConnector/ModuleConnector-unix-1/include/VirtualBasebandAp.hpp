@@ -0,0 +1,84 @@
+#ifndef VIRTUALBASEBANDAP_HPP
+#define VIRTUALBASEBANDAP_HPP
+
+#include "Data.hpp"
+
+namespace XeThru {
+
+/**
+ * @class VirtualBasebandAp
+ *
+ * Provides the baseband amplitude/phase output of an \ref X4M200 or \ref X4M300 computed on
+ * the host from the baseband I/Q output.
+ *
+ * Enabling both XTS_ID_BASEBAND_IQ and XTS_ID_BASEBAND_AMPLITUDE_PHASE with set_output_control
+ * roughly doubles the traffic on the serial link. With this class only I/Q needs to be
+ * enabled; code written against peek_message_baseband_ap and read_message_baseband_ap keeps
+ * working when given a VirtualBasebandAp instead of the module interface.
+ *
+ * @code
+ * X4M300 &x4m300 = mc.get_x4m300();
+ * x4m300.set_output_control(XTS_ID_BASEBAND_IQ, XTID_OUTPUT_CONTROL_ENABLE);
+ * VirtualBasebandAp<X4M300> ap_output(x4m300);
+ * BasebandApData ap;
+ * while (ap_output.read_message_baseband_ap(&ap) == 0) {
+ *     // ...
+ * }
+ * @endcode
+ *
+ * @note The I/Q messages are consumed by this class; use \ref read_message_baseband_ap_iq to
+ * get both representations of a frame.
+ * @see BasebandIqData::to_baseband_ap
+ */
+template<typename Module>
+class VirtualBasebandAp
+{
+public:
+    /**
+     * Constructs the virtual output for the given module interface.
+     */
+    explicit VirtualBasebandAp(Module &module) : module(module) {}
+
+    /**
+     * @return number of baseband messages available in the queue.
+     */
+    int peek_message_baseband_ap() { return module.peek_message_baseband_iq(); }
+
+    /**
+     * Reads one baseband I/Q message from the module and converts it to amplitude/phase.
+     *
+     * @param[out] baseband_ap: the converted message
+     * @return 0 on success, otherwise returns 1
+     */
+    int read_message_baseband_ap(BasebandApData * baseband_ap)
+    {
+        if (module.read_message_baseband_iq(&baseband_iq) != 0)
+            return 1;
+        baseband_iq.to_baseband_ap(baseband_ap);
+        return 0;
+    }
+
+    /**
+     * Reads one baseband I/Q message from the module and returns both the I/Q message
+     * and its amplitude/phase conversion.
+     *
+     * @param[out] baseband_ap: the converted message
+     * @param[out] baseband_iq: the message as read from the module
+     * @return 0 on success, otherwise returns 1
+     */
+    int read_message_baseband_ap_iq(BasebandApData * baseband_ap, BasebandIqData * baseband_iq)
+    {
+        if (module.read_message_baseband_iq(baseband_iq) != 0)
+            return 1;
+        baseband_iq->to_baseband_ap(baseband_ap);
+        return 0;
+    }
+
+private:
+    Module &module;
+    BasebandIqData baseband_iq;
+};
+
+} // namespace XeThru
+
+#endif // VIRTUALBASEBANDAP_HPP
@@ -4,7 +4,10 @@
 #include "RecordingOptions.hpp"
 #include "LockedRadarForward.hpp"
 #include "Data.hpp"
+#include "FramePool.hpp"
+#include "MessageWait.hpp"
 
+#include <chrono>
 #include <cinttypes>
 #include <string>
 #include <vector>
@@ -384,6 +387,28 @@ public:
     */
     int read_message_data_float(XeThru::DataFloat * data_float);
 
+    /**
+    * @brief Reads a single data float message from internal queue into a frame from \a pool.
+    *
+    * The frame is recycled when the last FrameRef to it is released, so the data vector
+    * keeps its capacity from one message to the next. Use one pool per connector.
+    *
+    * @param pool: pool to take the frame from.
+    * @param[out] frame: receives the frame on success; left empty on failure.
+    * @return execution status
+    * @see FramePool
+    */
+    int read_message_data_float(FramePool<DataFloat> & pool, FrameRef<DataFloat> * frame)
+    {
+        FrameRef<DataFloat> acquired = pool.acquire();
+        const int status = read_message_data_float(acquired.get());
+        if (status == 0)
+            *frame = std::move(acquired);
+        else
+            frame->reset();
+        return status;
+    }
+
     /**
      * Return number of RadarRf messages available in queue.
      *
@@ -444,6 +469,86 @@ public:
      */
     int read_message_radar_baseband_q15(XeThru::RadarBasebandQ15Data * radar_baseband_q15);
 
+    /**
+     * Read up to max_count data float messages from the queue in one call.
+     *
+     * Only messages already queued are read; this function does not block. The vector is
+     * grown to the number of queued messages, up to max_count, if needed but never shrunk,
+     * so entries keep their capacity between calls. Only the first entries, as many as the
+     * return value, are written.
+     *
+     * This is a convenience over a peek and read loop, not a faster path: each message is
+     * still read with \ref read_message_data_float, which locks the queue once per message.
+     *
+     * @param[out] data_floats: vector to read the messages into
+     * @param max_count: maximum number of messages to read
+     * @return number of messages read, or -1 if no message could be read
+     */
+    int read_messages_data_float(std::vector<XeThru::DataFloat> & data_floats, size_t max_count)
+    {
+        return read_messages(data_floats, max_count,
+                             &XEP::peek_message_data_float, &XEP::read_message_data_float);
+    }
+
+    /**
+     * Read up to max_count RadarRf messages from the queue in one call.
+     * See \ref read_messages_data_float for details.
+     *
+     * @param[out] radar_rf: vector to read the messages into
+     * @param max_count: maximum number of messages to read
+     * @return number of messages read, or -1 if no message could be read
+     */
+    int read_messages_radar_rf(std::vector<XeThru::RadarRfData> & radar_rf, size_t max_count)
+    {
+        return read_messages(radar_rf, max_count,
+                             &XEP::peek_message_radar_rf, &XEP::read_message_radar_rf);
+    }
+
+    /**
+     * Read up to max_count RadarRfNormalized messages from the queue in one call.
+     * See \ref read_messages_data_float for details.
+     *
+     * @param[out] radar_rf_normalized: vector to read the messages into
+     * @param max_count: maximum number of messages to read
+     * @return number of messages read, or -1 if no message could be read
+     */
+    int read_messages_radar_rf_normalized(std::vector<XeThru::RadarRfNormalizedData> & radar_rf_normalized,
+                                          size_t max_count)
+    {
+        return read_messages(radar_rf_normalized, max_count,
+                             &XEP::peek_message_radar_rf_normalized, &XEP::read_message_radar_rf_normalized);
+    }
+
+    /**
+     * Read up to max_count RadarBasebandFloat messages from the queue in one call.
+     * See \ref read_messages_data_float for details.
+     *
+     * @param[out] radar_baseband_float: vector to read the messages into
+     * @param max_count: maximum number of messages to read
+     * @return number of messages read, or -1 if no message could be read
+     */
+    int read_messages_radar_baseband_float(std::vector<XeThru::RadarBasebandFloatData> & radar_baseband_float,
+                                           size_t max_count)
+    {
+        return read_messages(radar_baseband_float, max_count,
+                             &XEP::peek_message_radar_baseband_float, &XEP::read_message_radar_baseband_float);
+    }
+
+    /**
+     * Read up to max_count RadarBasebandQ15 messages from the queue in one call.
+     * See \ref read_messages_data_float for details.
+     *
+     * @param[out] radar_baseband_q15: vector to read the messages into
+     * @param max_count: maximum number of messages to read
+     * @return number of messages read, or -1 if no message could be read
+     */
+    int read_messages_radar_baseband_q15(std::vector<XeThru::RadarBasebandQ15Data> & radar_baseband_q15,
+                                         size_t max_count)
+    {
+        return read_messages(radar_baseband_q15, max_count,
+                             &XEP::peek_message_radar_baseband_q15, &XEP::read_message_radar_baseband_q15);
+    }
+
     /**
     * @brief Returns number of data string packets in internal queue.
     *
@@ -486,6 +591,48 @@ public:
     */
     int read_message_system(uint32_t *responsecode);
 
+    /**
+     * Returns which of the given data types have messages queued.
+     *
+     * @param data_types: bitmask of DataType flags to check. Supported flags are
+     * FloatDataType, ByteDataType, StringDataType, RadarRfDataType, RadarRfNormalizedDataType, RadarBasebandFloatDataType, RadarBasebandQ15DataType.
+     * @return the subset of data_types with at least one queued message
+     */
+    DataTypes queued_message_types(DataTypes data_types)
+    {
+        DataTypes ready = 0;
+        if ((data_types & FloatDataType) && peek_message_data_float() > 0)
+            ready |= FloatDataType;
+        if ((data_types & ByteDataType) && peek_message_data_byte() > 0)
+            ready |= ByteDataType;
+        if ((data_types & StringDataType) && peek_message_data_string() > 0)
+            ready |= StringDataType;
+        if ((data_types & RadarRfDataType) && peek_message_radar_rf() > 0)
+            ready |= RadarRfDataType;
+        if ((data_types & RadarRfNormalizedDataType) && peek_message_radar_rf_normalized() > 0)
+            ready |= RadarRfNormalizedDataType;
+        if ((data_types & RadarBasebandFloatDataType) && peek_message_radar_baseband_float() > 0)
+            ready |= RadarBasebandFloatDataType;
+        if ((data_types & RadarBasebandQ15DataType) && peek_message_radar_baseband_q15() > 0)
+            ready |= RadarBasebandQ15DataType;
+        return ready;
+    }
+
+    /**
+     * Waits until a message of one of the given data types is queued, or the timeout expires.
+     * Use this instead of polling the peek_message_* functions in a loop.
+     *
+     * @param data_types: bitmask of DataType flags to wait for, for example
+     * FloatDataType | RadarBasebandQ15DataType. See \ref queued_message_types for supported flags.
+     * @param timeout: maximum time to wait
+     * @return the subset of data_types with queued messages, or 0 on timeout
+     */
+    DataTypes wait_for_message(DataTypes data_types, std::chrono::microseconds timeout)
+    {
+        return wait_for_ready_types([this, data_types]() { return queued_message_types(data_types); },
+                                    timeout);
+    }
+
     /**
      * @brief Searches for and returns a list of identifiers for all files of the specified type.
      *
@@ -592,6 +739,23 @@ public:
 
     
 private:
+    template<typename T>
+    int read_messages(std::vector<T> & items, size_t max_count, int (XEP::*peek)(), int (XEP::*read)(T *))
+    {
+        const int queued = (this->*peek)();
+        if (queued < 0)
+            return -1;
+        const size_t count = static_cast<size_t>(queued) < max_count ? static_cast<size_t>(queued) : max_count;
+        if (items.size() < count)
+            items.resize(count);
+        for (size_t n = 0; n < count; ++n) {
+            // Report the messages already taken from the queue, they would be lost otherwise.
+            if ((this->*read)(&items[n]) != 0)
+                return n > 0 ? static_cast<int>(n) : -1;
+        }
+        return static_cast<int>(count);
+    }
+
     std::unique_ptr<XEPPrivate> d_ptr;
 };
 
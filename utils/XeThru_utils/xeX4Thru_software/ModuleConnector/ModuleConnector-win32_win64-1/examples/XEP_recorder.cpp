@@ -80,8 +80,10 @@ int record(const std::string &device_name)
 
     // start streaming data
     xep.x4driver_set_fps(5);
+    // The recorder is fed on the connector's receive thread and no messages are read
+    // here, so there is nothing to wait_for_message on; just wait for Ctrl+C.
     while (!stop_recording) {
-        usleep(1000);
+        usleep(100000);
     }
 
     return 0;
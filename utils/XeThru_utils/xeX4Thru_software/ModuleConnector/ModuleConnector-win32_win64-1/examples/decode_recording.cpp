@@ -0,0 +1,204 @@
+#include "DataReader.hpp"
+#include "RecordDecoder.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+/** \example decode_recording.cpp
+ * this is a small example decoding every record of a recording into its Data.hpp struct,
+ * measuring the decoding throughput
+ */
+
+using namespace XeThru;
+
+// One output struct per data type, reused for every record.
+struct Decoded
+{
+    BasebandApData baseband_ap;
+    BasebandIqData baseband_iq;
+    SleepData sleep;
+    RespirationData respiration;
+    std::string text;
+    PulseDopplerFloatData pulsedoppler_float;
+    PulseDopplerByteData pulsedoppler_byte;
+    DataFloat data_float;
+    PresenceSingleData presence_single;
+    PresenceMovingListData presence_moving_list;
+    RespirationDetectionListData respiration_detection_list;
+    RespirationMovingListData respiration_moving_list;
+    VitalSignsData vital_signs;
+    SleepStageData sleep_stage;
+    RespirationNormalizedMovementListData respiration_normalized_movement_list;
+    RadarRfData radar_rf;
+    RadarRfNormalizedData radar_rf_normalized;
+    RadarBasebandFloatData radar_baseband_float;
+    RadarBasebandQ15Data radar_baseband_q15;
+};
+
+static int decode(const DataRecord &record, Decoded *out)
+{
+    switch (record.data_type) {
+    case BasebandApDataType: return decode_record(record, &out->baseband_ap);
+    case BasebandIqDataType: return decode_record(record, &out->baseband_iq);
+    case SleepDataType: return decode_record(record, &out->sleep);
+    case RespirationDataType: return decode_record(record, &out->respiration);
+    case StringDataType: return decode_record(record, &out->text);
+    case PulseDopplerFloatDataType:
+    case NoiseMapFloatDataType: return decode_record(record, &out->pulsedoppler_float);
+    case PulseDopplerByteDataType:
+    case NoiseMapByteDataType: return decode_record(record, &out->pulsedoppler_byte);
+    case FloatDataType: return decode_record(record, &out->data_float);
+    case PresenceSingleDataType: return decode_record(record, &out->presence_single);
+    case PresenceMovingListDataType: return decode_record(record, &out->presence_moving_list);
+    case RespirationDetectionListDataType: return decode_record(record, &out->respiration_detection_list);
+    case RespirationMovingListDataType: return decode_record(record, &out->respiration_moving_list);
+    case VitalSignsDataType: return decode_record(record, &out->vital_signs);
+    case SleepStageDataType: return decode_record(record, &out->sleep_stage);
+    case RespirationNormalizedMovementListDataType:
+        return decode_record(record, &out->respiration_normalized_movement_list);
+    case RadarRfDataType: return decode_record(record, &out->radar_rf);
+    case RadarRfNormalizedDataType: return decode_record(record, &out->radar_rf_normalized);
+    case RadarBasebandFloatDataType: return decode_record(record, &out->radar_baseband_float);
+    case RadarBasebandQ15DataType: return decode_record(record, &out->radar_baseband_q15);
+    default: return 1;
+    }
+}
+
+static bool same_sleep_data(const SleepData &a, const SleepData &b)
+{
+    return a.frame_counter == b.frame_counter && a.sensor_state == b.sensor_state &&
+        a.respiration_rate == b.respiration_rate && a.distance == b.distance &&
+        a.signal_quality == b.signal_quality && a.movement_slow == b.movement_slow &&
+        a.movement_fast == b.movement_fast;
+}
+
+static bool same_vital_signs(const VitalSignsData &a, const VitalSignsData &b)
+{
+    return a.frame_counter == b.frame_counter && a.sensor_state == b.sensor_state &&
+        a.respiration_rate == b.respiration_rate && a.respiration_distance == b.respiration_distance &&
+        a.heart_rate == b.heart_rate && a.normalized_movement_slow == b.normalized_movement_slow &&
+        a.normalized_movement_fast == b.normalized_movement_fast;
+}
+
+// Checks the CSV decoders against the conversions of DataRecord.
+static bool check_csv_record(const DataRecord &record, Decoded *out)
+{
+    bool ok = true;
+    if (record.data_type == SleepDataType && !record.is_csv_header()) {
+        const SleepData expected = record.to_sleep_data(&ok);
+        return ok && decode_record(record, &out->sleep) == 0 && same_sleep_data(out->sleep, expected);
+    }
+    if (record.data_type == VitalSignsDataType && !record.is_csv_header()) {
+        const VitalSignsData expected = record.to_vitalsigns_data(&ok);
+        return ok && decode_record(record, &out->vital_signs) == 0 && same_vital_signs(out->vital_signs, expected);
+    }
+    return true;
+}
+
+// Decodes a sleep record as written by the recorder.
+static int check_csv_decoding()
+{
+    const std::string row = "2019-01-24T14:18:08.123+01:00;1234;0;14.5;0.82;8;12.3;4.5\n";
+    DataRecord record;
+    record.data.assign(row.begin(), row.end());
+    record.data_type = SleepDataType;
+    record.epoch = 0;
+    record.is_valid = true;
+    record.is_user_header = false;
+
+    SleepData sleep;
+    if (decode_record(record, &sleep) != 0 || sleep.frame_counter != 1234 || sleep.sensor_state != 0 ||
+        sleep.respiration_rate != 14.5f || sleep.distance != 0.82f || sleep.signal_quality != 8 ||
+        sleep.movement_slow != 12.3f || sleep.movement_fast != 4.5f) {
+        std::cout << "ERROR: failed to decode CSV sleep record" << std::endl;
+        return 1;
+    }
+    Decoded decoded;
+    if (!check_csv_record(record, &decoded)) {
+        std::cout << "ERROR: CSV sleep record decoded differently by DataRecord::to_sleep_data" << std::endl;
+        return 1;
+    }
+    const std::string header = "TimeStamp;FrameCounter;State;RPM;ObjectDistance;SignalQuality;MovementSlow;MovementFast\n";
+    record.data.assign(header.begin(), header.end());
+    if (decode_record(record, &sleep) == 0) {
+        std::cout << "ERROR: decoded CSV header as sleep record" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int decode_recording(const std::string &meta_filename, int passes)
+{
+    if (check_csv_decoding() != 0)
+        return 1;
+
+    DataReader reader;
+    if (reader.open(meta_filename) != 0) {
+        std::cout << "ERROR: failed to open recording" << std::endl;
+        return 1;
+    }
+
+    // Read the recording into memory first, so that only decoding is measured.
+    std::vector<DataRecord> records;
+    size_t bytes = 0;
+    while (!reader.at_end()) {
+        records.push_back(reader.read_record());
+        if (!records.back().is_valid) {
+            std::cout << "ERROR: failed to read record" << std::endl;
+            return 1;
+        }
+        bytes += records.back().data.size();
+    }
+
+    Decoded decoded;
+    std::map<uint32_t, size_t> decoded_count;
+    std::map<uint32_t, size_t> failed_count;
+    for (size_t n = 0; n < records.size(); ++n) {
+        if (records[n].is_user_header)
+            continue;
+        if (!check_csv_record(records[n], &decoded)) {
+            std::cout << "ERROR: record " << n << " decoded differently by DataRecord" << std::endl;
+            return 1;
+        }
+        if (decode(records[n], &decoded) == 0)
+            ++decoded_count[records[n].data_type];
+        else
+            ++failed_count[records[n].data_type];
+    }
+    for (std::map<uint32_t, size_t>::const_iterator it = decoded_count.begin(); it != decoded_count.end(); ++it)
+        std::cout << "data type " << it->first << ": " << it->second << " records decoded" << std::endl;
+    for (std::map<uint32_t, size_t>::const_iterator it = failed_count.begin(); it != failed_count.end(); ++it)
+        std::cout << "data type " << it->first << ": " << it->second << " records not decoded" << std::endl;
+
+    size_t failures = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+        for (size_t n = 0; n < records.size(); ++n)
+            failures += decode(records[n], &decoded);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double total_records = static_cast<double>(records.size()) * passes;
+    const double total_bytes = static_cast<double>(bytes) * passes;
+    std::cout << records.size() << " records, " << bytes << " bytes, " << passes << " passes, "
+              << failures / passes << " not decoded per pass" << std::endl;
+    std::cout << "decoded " << total_records / seconds / 1e6 << " Mrecords/s, "
+              << total_bytes / seconds / (1024 * 1024) << " MiB/s" << std::endl;
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cout << "decode_recording <xethru recording meta file> [passes]" << std::endl;
+        return 1;
+    }
+
+    const int passes = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+    return decode_recording(argv[1], passes);
+}
@@ -3,6 +3,9 @@
 
 #include "Bytes.hpp"
 #include "datatypes.h"
+#include "RadarKernels.hpp"
+#include <complex>
+#include <type_traits>
 #include <vector>
 namespace XeThru {
 
@@ -52,6 +55,15 @@ struct DataFloat
         return data;
     }
 
+    /**
+     * Moves the data out of the struct, leaving it empty.
+     */
+    std::vector<float> take_data() {
+        std::vector<float> out;
+        out.swap(data);
+        return out;
+    }
+
     std::vector<float> data;
 };
 
@@ -245,6 +257,16 @@ public:
      */
     const std::vector<float> & get_phase() { return phase; }
 
+    /**
+     * Moves the amplitude vector out of the object, leaving it empty.
+     */
+    std::vector<float> take_amplitude() { std::vector<float> out; out.swap(amplitude); return out; }
+
+    /**
+     * Moves the phase vector out of the object, leaving it empty.
+     */
+    std::vector<float> take_phase() { std::vector<float> out; out.swap(phase); return out; }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -333,6 +355,42 @@ public:
      */
     const std::vector<float> & get_Q() { return q_data; }
 
+    /**
+     * Moves the in phase and quadrature phase vectors out of the object, leaving them empty.
+     */
+    std::vector<float> take_I() { std::vector<float> out; out.swap(i_data); return out; }
+    std::vector<float> take_Q() { std::vector<float> out; out.swap(q_data); return out; }
+
+    /**
+     * Copies the I/Q samples into \a iq as interleaved complex values, e.g. as input to an FFT.
+     * The vector is resized to the number of bins and keeps its capacity between calls.
+     */
+    void get_iq(std::vector<std::complex<float> > & iq) const
+    {
+        iq.resize(i_data.size() < q_data.size() ? i_data.size() : q_data.size());
+        interleave_iq(i_data.data(), q_data.data(), iq.data(), iq.size());
+    }
+
+    /**
+     * Converts the frame to amplitude/phase form, as sent by the module as BasebandApData.
+     * The vectors of \a baseband_ap keep their capacity between calls.
+     * @see iq_to_amplitude_phase
+     */
+    void to_baseband_ap(BasebandApData * baseband_ap) const
+    {
+        const size_t count = i_data.size() < q_data.size() ? i_data.size() : q_data.size();
+        baseband_ap->frame_counter = frame_counter;
+        baseband_ap->num_bins = num_bins;
+        baseband_ap->bin_length = bin_length;
+        baseband_ap->sample_frequency = sample_frequency;
+        baseband_ap->carrier_frequency = carrier_frequency;
+        baseband_ap->range_offset = range_offset;
+        baseband_ap->amplitude.resize(count);
+        baseband_ap->phase.resize(count);
+        iq_to_amplitude_phase(i_data.data(), q_data.data(),
+                              baseband_ap->amplitude.data(), baseband_ap->phase.data(), count);
+    }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -415,6 +473,11 @@ public:
      */
     const std::vector<uint32_t> & get_data() { return data; }
 
+    /**
+     * Moves the data vector out of the object, leaving it empty.
+     */
+    std::vector<uint32_t> take_data() { std::vector<uint32_t> out; out.swap(data); return out; }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -498,6 +561,11 @@ public:
      */
     const std::vector<float> & get_data() { return data; }
 
+    /**
+     * Moves the data vector out of the object, leaving it empty.
+     */
+    std::vector<float> take_data() { std::vector<float> out; out.swap(data); return out; }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -595,6 +663,33 @@ public:
      */
     const std::vector<float> & get_Q() { return q_data; }
 
+    /**
+     * Moves the in phase and quadrature phase vectors out of the object, leaving them empty.
+     */
+    std::vector<float> take_I() { std::vector<float> out; out.swap(i_data); return out; }
+    std::vector<float> take_Q() { std::vector<float> out; out.swap(q_data); return out; }
+
+    /**
+     * Copies the I/Q samples into \a iq as interleaved complex values, e.g. as input to an FFT.
+     * The vector is resized to the number of bins and keeps its capacity between calls.
+     */
+    void get_iq(std::vector<std::complex<float> > & iq) const
+    {
+        iq.resize(i_data.size() < q_data.size() ? i_data.size() : q_data.size());
+        interleave_iq(i_data.data(), q_data.data(), iq.data(), iq.size());
+    }
+
+    /**
+     * Applies the phase noise correction given by \ref correction_i and \ref correction_q
+     * to the I/Q samples in place. Apply once per frame.
+     * @see XeThru::apply_phase_correction
+     */
+    void apply_phase_correction()
+    {
+        const size_t count = i_data.size() < q_data.size() ? i_data.size() : q_data.size();
+        XeThru::apply_phase_correction(i_data.data(), q_data.data(), count, correction_i, correction_q);
+    }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -718,6 +813,47 @@ public:
      */
     const std::vector<int16_t> & get_Q() { return q_data; }
 
+    /**
+     * Moves the in phase and quadrature phase vectors out of the object, leaving them empty.
+     */
+    std::vector<int16_t> take_I() { std::vector<int16_t> out; out.swap(i_data); return out; }
+    std::vector<int16_t> take_Q() { std::vector<int16_t> out; out.swap(q_data); return out; }
+
+    /**
+     * Copies the I/Q samples into \a iq as interleaved Q15 pairs.
+     * The vector is resized to the number of bins and keeps its capacity between calls.
+     */
+    void get_iq(std::vector<ComplexQ15> & iq) const
+    {
+        iq.resize(i_data.size() < q_data.size() ? i_data.size() : q_data.size());
+        interleave_iq(i_data.data(), q_data.data(), iq.data(), iq.size());
+    }
+
+    /**
+     * Converts the I/Q samples to float, multiplied by \ref scaling_factor.
+     * The vectors are resized to the number of bins and keep their capacity between calls.
+     * @see q15_to_float
+     */
+    void to_float(std::vector<float> & i, std::vector<float> & q) const
+    {
+        i.resize(i_data.size());
+        q.resize(q_data.size());
+        q15_to_float(i_data.data(), i.data(), i.size(), scaling_factor);
+        q15_to_float(q_data.data(), q.data(), q.size(), scaling_factor);
+    }
+
+    /**
+     * Converts the I/Q samples to float like \ref to_float and applies the phase noise
+     * correction given by \ref correction_i and \ref correction_q.
+     * @see XeThru::apply_phase_correction
+     */
+    void to_corrected_float(std::vector<float> & i, std::vector<float> & q) const
+    {
+        to_float(i, q);
+        const size_t count = i.size() < q.size() ? i.size() : q.size();
+        XeThru::apply_phase_correction(i.data(), q.data(), count, correction_i, correction_q);
+    }
+
     /**
      * A sequential counter from the radar data. Incremented for each captured frame.
      */
@@ -844,6 +980,11 @@ public:
     const std::vector<float> &get_detection_distance_items() { return detection_distance_items; }
     const std::vector<float> &get_radar_cross_section() { return radar_cross_section_items; }
     const std::vector<float> &get_detection_velocity_items(){ return detection_velocity_items;}
+    std::vector<float> take_movement_slow_items() { std::vector<float> out; out.swap(movement_slow_items); return out; }
+    std::vector<float> take_movement_fast_items() { std::vector<float> out; out.swap(movement_fast_items); return out; }
+    std::vector<float> take_detection_distance_items() { std::vector<float> out; out.swap(detection_distance_items); return out; }
+    std::vector<float> take_radar_cross_section_items() { std::vector<float> out; out.swap(radar_cross_section_items); return out; }
+    std::vector<float> take_detection_velocity_items() { std::vector<float> out; out.swap(detection_velocity_items); return out; }
 };
 
 
@@ -869,6 +1010,8 @@ struct RespirationMovingListData
     std::vector<float> movement_fast_items;
     const std::vector<float> & get_movement_slow_items() { return movement_slow_items; }
     const std::vector<float> & get_movement_fast_items() { return movement_fast_items; }
+    std::vector<float> take_movement_slow_items() { std::vector<float> out; out.swap(movement_slow_items); return out; }
+    std::vector<float> take_movement_fast_items() { std::vector<float> out; out.swap(movement_fast_items); return out; }
 };
 
 
@@ -896,6 +1039,9 @@ struct RespirationDetectionListData
     const std::vector<float> & get_detection_distance_items() { return detection_distance_items; }
     const std::vector<float> & get_detection_radar_cross_section_items() { return detection_radar_cross_section_items; }
     const std::vector<float> & get_detection_velocity_items() { return detection_velocity_items; }
+    std::vector<float> take_detection_distance_items() { std::vector<float> out; out.swap(detection_distance_items); return out; }
+    std::vector<float> take_detection_radar_cross_section_items() { std::vector<float> out; out.swap(detection_radar_cross_section_items); return out; }
+    std::vector<float> take_detection_velocity_items() { std::vector<float> out; out.swap(detection_velocity_items); return out; }
 };
 
 /**
@@ -925,6 +1071,8 @@ struct RespirationNormalizedMovementListData
     uint32_t count;
     std::vector<float> normalized_movement_slow_items;
     std::vector<float> normalized_movement_fast_items;
+    std::vector<float> take_normalized_movement_slow_items() { std::vector<float> out; out.swap(normalized_movement_slow_items); return out; }
+    std::vector<float> take_normalized_movement_fast_items() { std::vector<float> out; out.swap(normalized_movement_fast_items); return out; }
 };
 
 /**
@@ -980,6 +1128,8 @@ struct Files
     std::vector<int32_t> file_identifier_items;
     std::vector<int32_t> get_file_type_items() { return file_type_items; }
     std::vector<int32_t> get_file_identifier_items() { return file_identifier_items; }
+    std::vector<int32_t> take_file_type_items() { std::vector<int32_t> out; out.swap(file_type_items); return out; }
+    std::vector<int32_t> take_file_identifier_items() { std::vector<int32_t> out; out.swap(file_identifier_items); return out; }
 };
 
 /**
@@ -1015,6 +1165,11 @@ public:
      */
     const std::vector<float> & get_data() { return data; }
 
+    /**
+     * Moves the data vector out of the object, leaving it empty.
+     */
+    std::vector<float> take_data() { std::vector<float> out; out.swap(data); return out; }
+
     /**
      * Frame counter generated from chip data rate
      */
@@ -1110,6 +1265,11 @@ public:
      */
     const Bytes & get_data() { return data; }
 
+    /**
+     * Moves the data vector out of the object, leaving it empty.
+     */
+    Bytes take_data() { Bytes out; out.swap(data); return out; }
+
     /**
      * Frame counter generated from chip data rate
      */
@@ -1213,6 +1373,11 @@ struct DataRecord
      */
     const Bytes &get_data() { return data; }
 
+    /**
+     * Moves the data out of the record, leaving it empty.
+     */
+    Bytes take_data() { Bytes out; out.swap(data); return out; }
+
     bool is_csv_header() const;
     Bytes to_binary_packet(bool *ok = nullptr) const;
     SleepData to_sleep_data(bool *ok = nullptr) const;
@@ -1226,6 +1391,106 @@ struct DataRecord
     uint32_t meta_version;
 };
 
+/**
+ * @struct RecordView
+ *
+ * Refers to a data record without owning it, e.g. a record in a recording mapped into
+ * memory by \ref MappedDataReader. The view is valid as long as its source is open.
+ *
+ * @param data Points to the record bytes, in the same format as \ref DataRecord::data.
+ * @param size Specifies the number of bytes at \a data.
+ * @param data_type Specifies the data type for the record (see \ref DataType).
+ * @param epoch Specifies the date/time the record was written to disk as number of milliseconds since 1970.01.01.
+ * @param is_user_header Specifies whether the data contains custom user header.
+ * @param meta_version Specifies the version of the meta file the record was read from.
+ */
+struct RecordView
+{
+    RecordView() : data(nullptr), size(0), data_type(0), epoch(0), is_user_header(false), meta_version(0) {}
+
+    /**
+     * @return a DataRecord holding a copy of the record.
+     */
+    DataRecord to_data_record() const
+    {
+        DataRecord record;
+        record.data.assign(data, data + size);
+        record.data_type = data_type;
+        record.epoch = epoch;
+        record.is_valid = data != nullptr;
+        record.is_user_header = is_user_header;
+        record.meta_version = meta_version;
+        return record;
+    }
+
+    const uint8_t *data;
+    uint32_t size;
+    uint32_t data_type;
+    int64_t epoch;
+    bool is_user_header;
+    uint32_t meta_version;
+};
+
+
+/*
+ * Move and reuse semantics of the message types.
+ *
+ * Every type in this file is nothrow movable: moving a message moves its vectors without
+ * copying samples, and std::vector and other containers of messages move their elements
+ * when they grow. The take_* accessors move a single vector out of a message.
+ *
+ * Reading into an existing object, e.g. with read_message_* or DataReader::read_record,
+ * overwrites its fields. Keep one object per stream, or use a FramePool, so that storage
+ * allocated for earlier frames stays available to later ones. The conversions in this
+ * file (get_iq, to_float, to_corrected_float, to_baseband_ap) resize their output vectors
+ * and therefore only allocate when a frame is larger than any before it. A vector taken
+ * out of a message is allocated again by the next read.
+ */
+namespace detail {
+template<typename T>
+struct is_nothrow_movable
+{
+    static const bool value = std::is_nothrow_move_constructible<T>::value &&
+        std::is_nothrow_move_assignable<T>::value;
+};
+
+// Maps a single DataType flag to its bit position, 0 to 31, to index per-type state.
+inline unsigned int data_type_index(uint32_t data_type)
+{
+    unsigned int index = 0;
+    for (uint32_t bits = data_type; bits > 1; bits >>= 1)
+        ++index;
+    return index;
+}
+} // namespace detail
+
+static_assert(detail::is_nothrow_movable<DetectionZoneLimits>::value, "DetectionZoneLimits must be nothrow movable");
+static_assert(detail::is_nothrow_movable<DataFloat>::value, "DataFloat must be nothrow movable");
+static_assert(detail::is_nothrow_movable<FrameArea>::value, "FrameArea must be nothrow movable");
+static_assert(detail::is_nothrow_movable<DetectionZone>::value, "DetectionZone must be nothrow movable");
+static_assert(detail::is_nothrow_movable<PeriodicNoisemapStore>::value, "PeriodicNoisemapStore must be nothrow movable");
+static_assert(detail::is_nothrow_movable<IoPinControl>::value, "IoPinControl must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RespirationData>::value, "RespirationData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<SleepData>::value, "SleepData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<BasebandApData>::value, "BasebandApData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<BasebandIqData>::value, "BasebandIqData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RadarRfData>::value, "RadarRfData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RadarRfNormalizedData>::value, "RadarRfNormalizedData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RadarBasebandFloatData>::value, "RadarBasebandFloatData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RadarBasebandQ15Data>::value, "RadarBasebandQ15Data must be nothrow movable");
+static_assert(detail::is_nothrow_movable<PresenceSingleData>::value, "PresenceSingleData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<PresenceMovingListData>::value, "PresenceMovingListData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RespirationMovingListData>::value, "RespirationMovingListData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RespirationDetectionListData>::value, "RespirationDetectionListData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RespirationNormalizedMovementListData>::value, "RespirationNormalizedMovementListData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<VitalSignsData>::value, "VitalSignsData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<SleepStageData>::value, "SleepStageData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<Files>::value, "Files must be nothrow movable");
+static_assert(detail::is_nothrow_movable<PulseDopplerFloatData>::value, "PulseDopplerFloatData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<PulseDopplerByteData>::value, "PulseDopplerByteData must be nothrow movable");
+static_assert(detail::is_nothrow_movable<DataRecord>::value, "DataRecord must be nothrow movable");
+static_assert(detail::is_nothrow_movable<RecordView>::value, "RecordView must be nothrow movable");
+
 
 } // namespace XeThru
 
@@ -0,0 +1,300 @@
+#ifndef DECIMATINGDATARECORDER_HPP
+#define DECIMATINGDATARECORDER_HPP
+
+#include "Bytes.hpp"
+#include "Data.hpp"
+#include "DataRecorder.hpp"
+#include "RangeDataReader.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+namespace XeThru {
+
+/**
+ * @struct DecimationInfo
+ *
+ * A decimation factor change written by \ref DecimatingDataRecorder.
+ *
+ * From the record on, the recording holds only the records of \a data_types whose frame
+ * counter is a multiple of \a factor. Records without a frame counter are counted per data
+ * type instead, starting from the first record of the type.
+ *
+ * @param data_types Specifies the decimated data types as a bitmask of \ref DataType flags.
+ * @param factor Specifies the decimation factor, 1 when no records are dropped.
+ *
+ * @see parse_decimation_record
+ */
+struct DecimationInfo
+{
+    DecimationInfo() : data_types(0), factor(1) {}
+
+    uint32_t data_types;
+    uint32_t factor;
+};
+
+namespace detail {
+
+static const char decimation_record_prefix[] = "xethru_decimation ";
+
+} // namespace detail
+
+/**
+ * Parses a decimation record written by \ref DecimatingDataRecorder.
+ * @param record Specifies a \ref StringDataType record.
+ * @param info Specifies the decimation to fill in.
+ * @return 0 on success, otherwise returns 1 (not a decimation record)
+ */
+inline int parse_decimation_record(const DataRecord &record, DecimationInfo *info)
+{
+    const size_t prefix_size = sizeof(detail::decimation_record_prefix) - 1;
+    if (record.data_type != StringDataType || record.data.size() <= prefix_size ||
+        std::memcmp(record.data.data(), detail::decimation_record_prefix, prefix_size) != 0)
+        return 1;
+    const std::string text(record.data.begin() + prefix_size, record.data.end());
+    unsigned int data_types = 0;
+    unsigned int factor = 0;
+    if (std::sscanf(text.c_str(), "data_types=%u factor=%u", &data_types, &factor) != 2 || factor == 0)
+        return 1;
+    info->data_types = data_types;
+    info->factor = factor;
+    return 0;
+}
+
+/**
+ * @class DecimatingDataRecorder
+ *
+ * The DecimatingDataRecorder class keeps the recorded data rate within a budget by
+ * decimating the high-rate data types evenly, as an alternative to
+ * \ref RecordingOptions::set_data_rate_limit.
+ *
+ * The recorder measures the byte rate of the data passed to \ref process once per second.
+ * When the rate exceeds the budget, it keeps every record of the low-rate data types, such
+ * as \ref SleepData and \ref PresenceSingleData, and spends the rest of the budget on the
+ * decimated types (by default \ref FloatDataType, \ref BasebandIqDataType and
+ * \ref PulseDopplerFloatDataType) by keeping only the frames whose frame counter is a
+ * multiple of the decimation factor. Every record of a kept frame is recorded, so the
+ * gaps in the recording are whole, evenly spaced frames.
+ *
+ * Each time the factor changes, a \ref StringDataType record stating the factor is
+ * recorded in line with the data, so readers can reconstruct the timing of the decimated
+ * frames, see \ref parse_decimation_record. Include \ref StringDataType in the data types
+ * passed to \ref DataRecorder::start_recording.
+ *
+ * The class only sees the data passed to its \ref process, which it forwards to
+ * \ref DataRecorder::process, the entry point for data generated by the application. The
+ * library records the data of a module on its own thread, which this class cannot reach,
+ * so it does not apply to recordings of a module; use
+ * \ref RecordingOptions::set_data_rate_limit for those.
+ *
+ * The data must have the layout of a recorded record of its type, as \ref DataReader
+ * returns it. For baseband, radar, pulse-Doppler and noise map data, the first 4 bytes are
+ * the frame counter, see \ref get_record_frame_counter. Other data types are counted per
+ * type instead.
+ *
+ * @code
+ * recorder.start_recording(BasebandIqDataType | SleepDataType | StringDataType, directory);
+ * DecimatingDataRecorder decimator(recorder, 200 * 1024);
+ * // For every record the application produces:
+ * decimator.process(data_type, record_bytes);
+ * @endcode
+ *
+ * @see DataRecorder, parse_decimation_record
+ */
+class DecimatingDataRecorder
+{
+public:
+    /**
+     * Constructs the recorder.
+     * @param data_recorder Specifies the recorder to write with. It must outlive this object.
+     * @param byte_rate_limit Specifies the budget in bytes per second. A negative budget
+     * disables decimation, so every record is kept.
+     */
+    DecimatingDataRecorder(DataRecorder &data_recorder, int64_t byte_rate_limit) :
+        recorder(data_recorder),
+        rate_limit(byte_rate_limit),
+        decimated_types(FloatDataType | BasebandIqDataType | PulseDopplerFloatDataType),
+        max_factor(64),
+        factor(1),
+        factor_recorded(false),
+        factor_due(true),
+        window_start(0),
+        window_decimated_bytes(0),
+        window_other_bytes(0),
+        byte_rate(0),
+        decimated_count(0)
+    {
+        std::fill(sequence, sequence + 32, 0);
+    }
+
+    /**
+     * Sets the budget. The new budget applies from the next once-per-second measurement.
+     * @param byte_rate_limit Specifies the budget in bytes per second. A negative budget
+     * disables decimation, so every record is kept.
+     */
+    void set_byte_rate_limit(int64_t byte_rate_limit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rate_limit = byte_rate_limit;
+    }
+
+    /**
+     * Sets the data types to decimate when the budget is exceeded. By default, this is
+     * FloatDataType | BasebandIqDataType | PulseDopplerFloatDataType.
+     * @param data_types Specifies the data types as a bitmask of \ref DataType flags.
+     */
+    void set_decimated_types(DataTypes data_types)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decimated_types = data_types & ~StringDataType;
+        factor_recorded = false;
+        factor_due = true;
+    }
+
+    /**
+     * Sets the largest decimation factor. By default, this is 64.
+     * @param limit Specifies the largest factor.
+     */
+    void set_max_factor(uint32_t limit)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        max_factor = std::max<uint32_t>(limit, 1);
+    }
+
+    /**
+     * Records the data, unless it belongs to a frame dropped by decimation.
+     * @param data_type Specifies the data type to process
+     * @param data Specifies the bytes to process, in the record layout of \a data_type
+     * @return true on success or when the data was dropped by decimation, otherwise returns false
+     */
+    bool process(DataType data_type, const Bytes &data)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        update_factor(data_type, data.size());
+        if (!(data_type & decimated_types))
+            return recorder.process(data_type, data);
+
+        uint32_t frame_counter;
+        if (!get_record_frame_counter(data_type, data.data(), static_cast<uint32_t>(data.size()), &frame_counter))
+            frame_counter = sequence[detail::data_type_index(data_type)]++;
+        if (frame_counter % factor != 0) {
+            ++decimated_count;
+            return true;
+        }
+        return recorder.process(data_type, data);
+    }
+
+    /**
+     * @return the current decimation factor, 1 when no records are dropped.
+     */
+    uint32_t get_factor() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return factor;
+    }
+
+    /**
+     * @return the byte rate of the data passed to \ref process over the last second, before decimation.
+     */
+    int64_t get_byte_rate() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return byte_rate;
+    }
+
+    /**
+     * @return the number of records dropped by decimation.
+     */
+    uint64_t get_decimated_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return decimated_count;
+    }
+
+private:
+    DecimatingDataRecorder(const DecimatingDataRecorder &other) = delete;
+    DecimatingDataRecorder& operator= (const DecimatingDataRecorder &other) = delete;
+
+    static int64_t now_ms()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Accounts the data to the current window and picks the factor once the window ends.
+    // A factor change is recorded right away; if that fails, e.g. because StringDataType
+    // is not recorded, it is retried once per window rather than for every record.
+    void update_factor(DataType data_type, size_t size)
+    {
+        const int64_t now = now_ms();
+        if (window_start == 0)
+            window_start = now;
+        if (data_type & decimated_types)
+            window_decimated_bytes += size;
+        else
+            window_other_bytes += size;
+
+        const int64_t elapsed = now - window_start;
+        if (elapsed >= 1000) {
+            const int64_t decimated_rate = static_cast<int64_t>(window_decimated_bytes) * 1000 / elapsed;
+            const int64_t other_rate = static_cast<int64_t>(window_other_bytes) * 1000 / elapsed;
+            byte_rate = decimated_rate + other_rate;
+            const int64_t budget = rate_limit - other_rate;
+            uint32_t next = 1;
+            if (rate_limit >= 0 && decimated_rate > 0 && byte_rate > rate_limit) {
+                next = budget <= 0 ? max_factor :
+                    static_cast<uint32_t>(std::min<int64_t>((decimated_rate + budget - 1) / budget, max_factor));
+            }
+            if (next != factor) {
+                factor = next;
+                factor_recorded = false;
+            }
+            factor_due = !factor_recorded;
+            window_start = now;
+            window_decimated_bytes = 0;
+            window_other_bytes = 0;
+        }
+        if (factor_due) {
+            factor_recorded = record_factor();
+            factor_due = false;
+        }
+    }
+
+    // Records the factor in line with the data, see parse_decimation_record.
+    bool record_factor()
+    {
+        char text[64];
+        const int length = std::snprintf(text, sizeof(text), "%sdata_types=%u factor=%u",
+                                         detail::decimation_record_prefix,
+                                         static_cast<unsigned int>(decimated_types),
+                                         static_cast<unsigned int>(factor));
+        if (length <= 0 || !recorder.is_recording(StringDataType))
+            return false;
+        const Bytes record(text, text + std::min<size_t>(length, sizeof(text) - 1));
+        return recorder.process(StringDataType, record);
+    }
+
+    DataRecorder &recorder;
+    mutable std::mutex mutex;
+    int64_t rate_limit;
+    uint32_t decimated_types;
+    uint32_t max_factor;
+    uint32_t factor;
+    bool factor_recorded;
+    bool factor_due;
+    int64_t window_start;
+    uint64_t window_decimated_bytes;
+    uint64_t window_other_bytes;
+    int64_t byte_rate;
+    uint64_t decimated_count;
+    uint32_t sequence[32];
+};
+
+} // namespace XeThru
+
+#endif // DECIMATINGDATARECORDER_HPP
@@ -0,0 +1,173 @@
+#ifndef FILEAVAILABLEDISPATCHER_HPP
+#define FILEAVAILABLEDISPATCHER_HPP
+
+#include "DataRecorder.hpp"
+#include "datatypes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace XeThru {
+
+/**
+ * @class FileAvailableDispatcher
+ *
+ * The FileAvailableDispatcher class runs the file available callbacks of a
+ * \ref DataRecorder on a worker thread.
+ *
+ * \ref DataRecorder calls \ref DataRecorder::FileAvailableCallback and
+ * \ref DataRecorder::MetaFileAvailableCallback on the thread that rolled the recording
+ * over, i.e. the thread delivering data. Callbacks that upload, move or index the finished
+ * files then stall that thread. Subscribing through the dispatcher only queues the
+ * notification there; the callbacks run one at a time on the worker thread, in the order
+ * the files became available.
+ *
+ * Together with \ref AsyncDataRecorder, which moves the writes and thereby the rollovers to
+ * a writer thread, a split recording costs the receive thread no more at a rollover than
+ * at any other record.
+ *
+ * @note Unsubscribe from the recorder before destroying the dispatcher. The destructor
+ * runs the callbacks still queued.
+ *
+ * @code
+ * FileAvailableDispatcher dispatcher;
+ * dispatcher.subscribe_to_file_available(recorder, AllDataTypes, &upload_file);
+ * dispatcher.subscribe_to_meta_file_available(recorder, &index_recording);
+ * @endcode
+ *
+ * @see DataRecorder::subscribe_to_file_available, DataRecorder::subscribe_to_meta_file_available
+ */
+class FileAvailableDispatcher
+{
+public:
+    /**
+     * Constructs the dispatcher and starts the worker thread.
+     */
+    FileAvailableDispatcher() : busy(false), stopping(false)
+    {
+        worker = std::thread(&FileAvailableDispatcher::run, this);
+    }
+
+    /**
+     * Runs the queued callbacks and stops the worker thread.
+     */
+    ~FileAvailableDispatcher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_ready.notify_one();
+        worker.join();
+    }
+
+    /**
+     * Subscribes \a callback to \a recorder, see \ref DataRecorder::subscribe_to_file_available.
+     * The callback runs on the worker thread.
+     * @return 0 on success, otherwise returns 1
+     */
+    int subscribe_to_file_available(DataRecorder &recorder, DataTypes data_types,
+                                    const DataRecorder::FileAvailableCallback &callback)
+    {
+        return recorder.subscribe_to_file_available(data_types, wrap_file_available(callback));
+    }
+
+    /**
+     * Subscribes \a callback to \a recorder, see \ref DataRecorder::subscribe_to_meta_file_available.
+     * The callback runs on the worker thread.
+     * @return 0 on success, otherwise returns 1
+     */
+    int subscribe_to_meta_file_available(DataRecorder &recorder,
+                                         const DataRecorder::MetaFileAvailableCallback &callback)
+    {
+        return recorder.subscribe_to_meta_file_available(wrap_meta_file_available(callback));
+    }
+
+    /**
+     * @return a callback that queues the call of \a callback on the worker thread.
+     */
+    DataRecorder::FileAvailableCallback wrap_file_available(const DataRecorder::FileAvailableCallback &callback)
+    {
+        return [this, callback](DataType data_type, const std::string &filename) {
+            post(std::bind(callback, data_type, filename));
+        };
+    }
+
+    /**
+     * @return a callback that queues the call of \a callback on the worker thread.
+     */
+    DataRecorder::MetaFileAvailableCallback wrap_meta_file_available(
+        const DataRecorder::MetaFileAvailableCallback &callback)
+    {
+        return [this, callback](const std::string &session_id, const std::string &meta_filename) {
+            post(std::bind(callback, session_id, meta_filename));
+        };
+    }
+
+    /**
+     * Waits until the callbacks queued so far have run.
+     */
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this]() { return tasks.empty() && !busy; });
+    }
+
+    /**
+     * @return the number of callbacks queued and not yet run.
+     */
+    size_t get_pending_count() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tasks.size();
+    }
+
+private:
+    FileAvailableDispatcher(const FileAvailableDispatcher &other) = delete;
+    FileAvailableDispatcher& operator= (const FileAvailableDispatcher &other) = delete;
+
+    void post(const std::function<void()> &task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(task);
+        }
+        work_ready.notify_one();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            work_ready.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty())
+                return;
+            std::function<void()> task;
+            task.swap(tasks.front());
+            tasks.pop_front();
+            busy = true;
+            lock.unlock();
+            task();
+            lock.lock();
+            busy = false;
+            if (tasks.empty())
+                idle.notify_all();
+        }
+    }
+
+    mutable std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable idle;
+    std::deque<std::function<void()> > tasks;
+    bool busy;
+    bool stopping;
+    std::thread worker;
+};
+
+} // namespace XeThru
+
+#endif // FILEAVAILABLEDISPATCHER_HPP
@@ -0,0 +1,259 @@
+#ifndef FRAMEPOOL_HPP
+#define FRAMEPOOL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace XeThru {
+
+template<typename T> class FramePool;
+
+/**
+ * @class FrameRef
+ *
+ * Reference counted handle to a frame owned by a \ref FramePool.
+ *
+ * Copying a FrameRef shares the frame, it does not copy the frame data. When the last
+ * reference goes away the frame is returned to its pool and handed out again by the next
+ * \ref FramePool::acquire, with the capacity of its vectors intact. The reference count is
+ * stored in the frame itself, so neither copying nor releasing a FrameRef allocates.
+ *
+ * A FrameRef may be released on any thread. It remains valid after its pool is destroyed.
+ *
+ * @see FramePool
+ */
+template<typename T>
+class FrameRef
+{
+public:
+    /**
+     * Constructs an empty reference.
+     */
+    FrameRef() : node(nullptr) {}
+
+    /**
+     * Copy constructor. Shares the frame with \a other.
+     */
+    FrameRef(const FrameRef &other) : node(other.node)
+    {
+        if (node)
+            node->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Move constructor. Leaves \a other empty.
+     */
+    FrameRef(FrameRef &&other) noexcept : node(other.node)
+    {
+        other.node = nullptr;
+    }
+
+    /**
+     * Releases the reference.
+     */
+    ~FrameRef() { reset(); }
+
+    /**
+     * Copy assignment operator.
+     */
+    FrameRef& operator= (const FrameRef &other)
+    {
+        FrameRef(other).swap(*this);
+        return *this;
+    }
+
+    /**
+     * Move assignment operator.
+     */
+    FrameRef& operator= (FrameRef &&other) noexcept
+    {
+        FrameRef(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    /**
+     * Releases the reference. The frame is returned to its pool if this was the last one.
+     */
+    void reset()
+    {
+        if (node && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            FramePool<T>::release(node);
+        node = nullptr;
+    }
+
+    void swap(FrameRef &other) noexcept
+    {
+        typename FramePool<T>::Node *tmp = node;
+        node = other.node;
+        other.node = tmp;
+    }
+
+    /**
+     * @return the number of references sharing the frame, or 0 if empty.
+     */
+    long use_count() const { return node ? node->refs.load(std::memory_order_relaxed) : 0; }
+
+    T * get() const { return node ? &node->frame : nullptr; }
+    T & operator* () const { return node->frame; }
+    T * operator-> () const { return &node->frame; }
+    explicit operator bool() const { return node != nullptr; }
+
+private:
+    friend class FramePool<T>;
+    explicit FrameRef(typename FramePool<T>::Node *node) : node(node) {}
+
+    typename FramePool<T>::Node *node;
+};
+
+/**
+ * @class FramePool
+ *
+ * Pool of reusable frames for the read_message_* functions.
+ *
+ * Reading every frame into a new object reallocates its vectors once per frame. A FramePool
+ * keeps released frames around so that the next read reuses their storage. Use one pool per
+ * \ref ModuleConnector and message type, and read with the pooled overloads, for example
+ * XEP::read_message_data_float(FramePool<DataFloat>&, FrameRef<DataFloat>*).
+ *
+ * The pool only grows. In steady state, when frames are released at the rate they are read
+ * and the frame size is stable, acquiring and releasing frames does not allocate.
+ *
+ * @code
+ * FramePool<DataFloat> pool;
+ * FrameRef<DataFloat> frame;
+ * while (xep.read_message_data_float(pool, &frame) == 0) {
+ *     consumer.push(frame); // shares the frame, no copy
+ * }
+ * @endcode
+ *
+ * @see FrameRef
+ */
+template<typename T>
+class FramePool
+{
+public:
+    /**
+     * Constructs the pool.
+     * @param reserve Specifies the number of frames to preallocate.
+     */
+    explicit FramePool(size_t reserve = 0) : state(new State)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->free_nodes.reserve(reserve);
+        for (size_t n = 0; n < reserve; ++n)
+            state->free_nodes.push_back(new Node(state));
+        state->total = reserve;
+    }
+
+    /**
+     * Destroys the pool. Frames still referenced are deleted when their last FrameRef goes away.
+     */
+    ~FramePool()
+    {
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            for (size_t n = 0; n < state->free_nodes.size(); ++n)
+                delete state->free_nodes[n];
+            state->total -= state->free_nodes.size();
+            state->free_nodes.clear();
+            state->closed = true;
+            last = state->total == 0;
+        }
+        if (last)
+            delete state;
+    }
+
+    /**
+     * Returns a frame from the pool, or a new frame if none is free. The frame keeps whatever
+     * content it had when it was released.
+     * @return a reference to the frame with a use count of 1.
+     */
+    FrameRef<T> acquire()
+    {
+        Node *node = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->free_nodes.empty()) {
+                node = state->free_nodes.back();
+                state->free_nodes.pop_back();
+            } else {
+                ++state->total;
+                // release() must never allocate, so make room for every frame in the pool.
+                state->free_nodes.reserve(state->total);
+            }
+        }
+        if (!node)
+            node = new Node(state);
+        node->refs.store(1, std::memory_order_relaxed);
+        return FrameRef<T>(node);
+    }
+
+    /**
+     * @return the number of frames owned by the pool, including frames in use.
+     */
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->total;
+    }
+
+    /**
+     * @return the number of frames ready to be acquired without allocation.
+     */
+    size_t available() const
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->free_nodes.size();
+    }
+
+private:
+    FramePool(const FramePool &other) = delete;
+    FramePool& operator= (const FramePool &other) = delete;
+
+    friend class FrameRef<T>;
+    struct Node;
+
+    struct State
+    {
+        State() : total(0), closed(false) {}
+        mutable std::mutex mutex;
+        std::vector<Node *> free_nodes;
+        size_t total;
+        bool closed;
+    };
+
+    struct Node
+    {
+        explicit Node(State *state) : refs(0), state(state) {}
+        T frame;
+        std::atomic<long> refs;
+        State *state;
+    };
+
+    static void release(Node *node)
+    {
+        State *state = node->state;
+        bool last = false;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->closed) {
+                state->free_nodes.push_back(node);
+                return;
+            }
+            last = --state->total == 0;
+        }
+        delete node;
+        if (last)
+            delete state;
+    }
+
+    State *state;
+};
+
+} // namespace XeThru
+
+#endif // FRAMEPOOL_HPP
@@ -0,0 +1,299 @@
+#ifndef MAPPEDDATAREADER_HPP
+#define MAPPEDDATAREADER_HPP
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+
+#include "Data.hpp"
+#include "DataReader.hpp"
+#include "RecordingIndex.hpp"
+#include "datatypes.h"
+
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace XeThru {
+
+/**
+ * @class MappedDataReader
+ *
+ * The MappedDataReader class reads a recording generated by \ref DataRecorder through
+ * memory mappings of its data files instead of read calls.
+ *
+ * \ref DataReader::read_record copies every record, first from disk and then into the
+ * returned \ref DataRecord. When a recording is scanned repeatedly, e.g. for training,
+ * this dominates. MappedDataReader returns \ref RecordView objects that point directly
+ * into the mapped data files, so reading a record neither copies nor allocates, and any
+ * record can be accessed by index.
+ *
+ * The records are located with a \ref RecordingIndex, which is built by reading the
+ * recording once and saved next to the meta file (*xethru_recording_meta.dat.index*).
+ * No copy of the data is written. Opening fails if the index cannot locate every record
+ * in the data files, e.g. for a chained recording in another folder; use
+ * \ref DataReader then.
+ *
+ * Filter, seek and end semantics are the same as for \ref DataReader. Record data is
+ * not aligned, read multi-byte fields with memcpy or the decoders in RecordDecoder.hpp.
+ *
+ * @code
+ * MappedDataReader reader;
+ * if (reader.open(meta_filename) != 0)
+ *     return 1;
+ * reader.set_filter(BasebandIqDataType);
+ * RecordView record;
+ * while (!reader.at_end()) {
+ *     reader.read_record(&record);
+ *     process(record.data, record.size);
+ * }
+ * @endcode
+ *
+ * @note Not available on Windows.
+ * @see DataReader, RecordView, RecordingIndex
+ */
+class MappedDataReader
+{
+public:
+    /**
+     * Constructs reader.
+     */
+    MappedDataReader() : current(0), filter(AllDataTypes) {}
+
+    /**
+     * Destroys the reader. Record views returned by the reader become invalid.
+     */
+    ~MappedDataReader() { close(); }
+
+    /**
+     * Opens a recording, building its index first if it is missing or out of date.
+     * @param meta_filename Specifies which recording (*xethru_recording_meta.dat*) to open
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, int depth = -1)
+    {
+        return open(meta_filename, depth, meta_filename + ".index");
+    }
+
+    /**
+     * Opens a recording using the given index filename, e.g. when the recording folder
+     * is not writable.
+     * @param meta_filename Specifies which recording (*xethru_recording_meta.dat*) to open
+     * @param depth Specifies the number of meta files to open in 'chained mode', see \ref DataReader::open.
+     * @param index_filename Specifies where to read or write the \ref RecordingIndex.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, int depth, const std::string &index_filename)
+    {
+        close();
+        if (index.open(meta_filename, depth, index_filename) != 0 || !index.has_data_files() ||
+            !map_files()) {
+            close();
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * @return true if the recording is successfully opened, otherwise returns false
+     */
+    bool is_open() const { return index.is_open(); }
+
+    /**
+     * Unmaps the data files. Record views returned by the reader become invalid.
+     */
+    void close()
+    {
+        for (size_t n = 0; n < maps.size(); ++n)
+            ::munmap(maps[n].address, maps[n].size);
+        maps.clear();
+        index.close();
+        current = 0;
+    }
+
+    /**
+     * @return true if no more data records is available for reading, otherwise returns false.
+     */
+    bool at_end() const { return next_match(current) >= index.size(); }
+
+    /**
+     * Returns the next record matching the filter and advances past it.
+     *
+     * @param[out] record Specifies the view to update.
+     * @return 0 on success, otherwise returns 1.
+     */
+    int read_record(RecordView *record)
+    {
+        const size_t index = next_match(current);
+        if (record_at(index, record) != 0)
+            return 1;
+        current = index + 1;
+        return 0;
+    }
+
+    /**
+     * Returns the next record matching the filter without advancing.
+     *
+     * @param[out] record Specifies the view to update.
+     * @return 0 on success, otherwise returns 1.
+     */
+    int peek_record(RecordView *record) const { return record_at(next_match(current), record); }
+
+    /**
+     * Returns a record by its index in the recording, regardless of the filter and the
+     * current position.
+     *
+     * @param record_index Specifies the record index, less than \ref get_record_count.
+     * @param[out] record Specifies the view to update.
+     * @return 0 on success, otherwise returns 1.
+     */
+    int record_at(size_t record_index, RecordView *record) const
+    {
+        if (record_index >= index.size())
+            return 1;
+        const detail::RecordIndexEntry &entry = index.entry(record_index);
+        record->data = static_cast<const uint8_t *>(maps[entry.file].address) + entry.offset;
+        record->size = entry.size;
+        record->data_type = entry.data_type;
+        record->epoch = entry.epoch;
+        record->is_user_header = entry.is_user_header != 0;
+        record->meta_version = index.get_meta_version();
+        return 0;
+    }
+
+    /**
+     * Sets the current position as specified.
+     * @param position Specifies the position as number of milliseconds.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_ms(int64_t position)
+    {
+        if (!is_open() || position < 0 || position > index.get_duration())
+            return 1;
+        current = index.record_index_ms(position);
+        return 0;
+    }
+
+    /**
+     * Sets the current position as specified.
+     * @param position Specifies the position as number of bytes.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_byte(int64_t position)
+    {
+        if (!is_open() || position < 0 || position > index.get_size())
+            return 1;
+        current = index.record_index_byte(position);
+        return 0;
+    }
+
+    /**
+     * Sets the filter used by \ref read_record and \ref peek_record.
+     * @param data_types Specifies the filter as a bitmask of \ref DataType flags.
+     * @return 0 success, otherwise returns 1
+     */
+    int set_filter(uint32_t data_types)
+    {
+        filter = data_types;
+        return 0;
+    }
+
+    /**
+     * @return the filter used by \ref read_record and \ref peek_record.
+     */
+    uint32_t get_filter() const { return filter; }
+
+    /**
+     * @return the start date/time for the recording as number of milliseconds since 1970.01.01.
+     */
+    int64_t get_start_epoch() const { return index.get_start_epoch(); }
+
+    /**
+     * @return the total duration of the recording as milliseconds.
+     */
+    int64_t get_duration() const { return index.get_duration(); }
+
+    /**
+     * @return the total size of the recording as number of bytes.
+     */
+    int64_t get_size() const { return index.get_size(); }
+
+    /**
+     * @return a bitmask of all data types included in the recording.
+     */
+    uint32_t get_data_types() const { return index.get_data_types(); }
+
+    /**
+     * @return the number of bytes of the largest record included in the recording.
+     */
+    uint32_t get_max_record_size() const { return index.get_max_record_size(); }
+
+    /**
+     * @return the number of records in the recording, regardless of the filter.
+     */
+    size_t get_record_count() const { return index.size(); }
+
+private:
+    MappedDataReader(const MappedDataReader &other) = delete;
+    MappedDataReader& operator= (const MappedDataReader &other) = delete;
+
+    struct Mapping
+    {
+        void *address;
+        size_t size;
+    };
+
+    size_t next_match(size_t record_index) const
+    {
+        while (record_index < index.size() && !(index.entry(record_index).data_type & filter))
+            ++record_index;
+        return record_index;
+    }
+
+    bool map_files()
+    {
+        const std::vector<std::string> &files = index.get_data_files();
+        for (size_t n = 0; n < files.size(); ++n) {
+            const int fd = ::open(files[n].c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+                return false;
+            struct stat st;
+            // A file still being recorded may have grown since it was indexed.
+            if (::fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < index.get_data_file_sizes()[n] ||
+                st.st_size == 0) {
+                ::close(fd);
+                return false;
+            }
+            Mapping mapping;
+            mapping.size = static_cast<size_t>(st.st_size);
+            mapping.address = ::mmap(nullptr, mapping.size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (mapping.address == MAP_FAILED)
+                return false;
+            ::madvise(mapping.address, mapping.size, MADV_SEQUENTIAL);
+            maps.push_back(mapping);
+        }
+        for (size_t n = 0; n < index.size(); ++n) {
+            const detail::RecordIndexEntry &entry = index.entry(n);
+            if (entry.file >= maps.size() || entry.offset > maps[entry.file].size ||
+                entry.size > maps[entry.file].size - entry.offset)
+                return false;
+        }
+        current = 0;
+        return true;
+    }
+
+    RecordingIndex index;
+    std::vector<Mapping> maps;
+    size_t current;
+    uint32_t filter;
+};
+
+} // namespace XeThru
+
+#endif // !_WIN32
+
+#endif // MAPPEDDATAREADER_HPP
@@ -0,0 +1,238 @@
+#ifndef MESSAGENOTIFIER_HPP
+#define MESSAGENOTIFIER_HPP
+
+#if !defined(_WIN32) && !defined(__MINGW32__)
+
+#include "MessageWait.hpp"
+#include "datatypes.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace XeThru {
+
+/**
+ * @class MessageNotifier
+ *
+ * The MessageNotifier class turns module message queues into pollable file descriptors.
+ *
+ * Each call to \ref watch returns a file descriptor that becomes readable when any of the
+ * given data types has messages queued on that module. One thread can then wait on many
+ * modules, \ref DataPlayer backed connectors and unrelated descriptors (e.g. serial ports)
+ * with a single select/poll/epoll call instead of running a polling thread per module.
+ *
+ * A single watcher thread per notifier checks the queues of all watched modules, so the
+ * thread count does not grow with the number of modules. On Linux the descriptor is an
+ * eventfd, elsewhere the read end of a pipe.
+ *
+ * After a descriptor is reported readable, call \ref clear before draining the queues.
+ * The descriptor is signalled again as long as messages remain queued.
+ *
+ * @code
+ * MessageNotifier notifier;
+ * const int fd = notifier.watch(mc.get_x4m300(), PresenceSingleDataType);
+ * // add fd to an epoll set, then when it is readable:
+ * MessageNotifier::clear(fd);
+ * while (x4m300.peek_message_presence_single() > 0)
+ *     x4m300.read_message_presence_single(&presence);
+ * @endcode
+ *
+ * @note Not available on Windows.
+ * @see XEP::queued_message_types, XEP::wait_for_message
+ */
+class MessageNotifier
+{
+public:
+    /**
+     * Function returning the subset of the given data types with queued messages.
+     */
+    typedef std::function<DataTypes(DataTypes)> QueuedTypesFunction;
+
+    /**
+     * Constructs the notifier. The watcher thread starts with the first \ref watch.
+     */
+    MessageNotifier() : stopping(false) {}
+
+    /**
+     * Stops the watcher thread and closes all descriptors returned by \ref watch.
+     */
+    ~MessageNotifier()
+    {
+        stopping = true;
+        if (watcher.joinable())
+            watcher.join();
+        for (size_t n = 0; n < sources.size(); ++n)
+            close_source(sources[n]);
+    }
+
+    /**
+     * Watches the given data types on a module interface, i.e. \ref XEP, \ref X4M200 or \ref X4M300.
+     * The interface must outlive the notifier or be removed with \ref unwatch.
+     *
+     * @param module Specifies the module interface.
+     * @param data_types Specifies the data types to watch as a bitmask of \ref DataType flags.
+     * @return a file descriptor that is readable while messages are queued, or -1 on failure.
+     */
+    template<typename Module>
+    auto watch(Module &module, DataTypes data_types)
+        -> decltype(module.queued_message_types(data_types), int())
+    {
+        Module *target = &module;
+        return watch([target](DataTypes types) { return target->queued_message_types(types); },
+                     data_types);
+    }
+
+    /**
+     * Watches the given data types using a custom queue check.
+     *
+     * @param queued_types Specifies the function used to check the queues.
+     * @param data_types Specifies the data types to watch as a bitmask of \ref DataType flags.
+     * @return a file descriptor that is readable while messages are queued, or -1 on failure.
+     */
+    int watch(const QueuedTypesFunction &queued_types, DataTypes data_types)
+    {
+        Source source;
+        source.data_types = data_types;
+        source.queued_types = queued_types;
+        if (!open_source(source))
+            return -1;
+        std::lock_guard<std::mutex> lock(mutex);
+        sources.push_back(source);
+        if (!watcher.joinable())
+            watcher = std::thread(&MessageNotifier::run, this);
+        return source.read_fd;
+    }
+
+    /**
+     * Stops watching and closes the descriptor returned by \ref watch.
+     * @return 0 on success, otherwise returns 1
+     */
+    int unwatch(int fd)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t n = 0; n < sources.size(); ++n) {
+            if (sources[n].read_fd == fd) {
+                close_source(sources[n]);
+                sources.erase(sources.begin() + n);
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    /**
+     * Resets a readable descriptor returned by \ref watch. Call before draining the queues.
+     */
+    static void clear(int fd)
+    {
+        uint64_t value;
+        while (::read(fd, &value, sizeof(value)) > 0) {
+        }
+    }
+
+private:
+    MessageNotifier(const MessageNotifier &other) = delete;
+    MessageNotifier& operator= (const MessageNotifier &other) = delete;
+
+    struct Source
+    {
+        Source() : data_types(0), read_fd(-1), write_fd(-1) {}
+        DataTypes data_types;
+        QueuedTypesFunction queued_types;
+        int read_fd;
+        int write_fd;
+    };
+
+    static bool open_source(Source &source)
+    {
+#if defined(__linux__)
+        source.read_fd = source.write_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        return source.read_fd >= 0;
+#else
+        int fds[2];
+        if (::pipe(fds) != 0)
+            return false;
+        for (int n = 0; n < 2; ++n) {
+            ::fcntl(fds[n], F_SETFL, ::fcntl(fds[n], F_GETFL) | O_NONBLOCK);
+            ::fcntl(fds[n], F_SETFD, FD_CLOEXEC);
+        }
+        source.read_fd = fds[0];
+        source.write_fd = fds[1];
+        return true;
+#endif
+    }
+
+    static void close_source(Source &source)
+    {
+        if (source.write_fd != source.read_fd)
+            ::close(source.write_fd);
+        ::close(source.read_fd);
+        source.read_fd = source.write_fd = -1;
+    }
+
+    static bool is_signalled(const Source &source)
+    {
+        struct pollfd pfd;
+        pfd.fd = source.read_fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        return ::poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN);
+    }
+
+    static void signal(const Source &source)
+    {
+        const uint64_t one = 1;
+        if (::write(source.write_fd, &one, source.write_fd == source.read_fd ? sizeof(one) : 1) < 0) {
+            // Counter or pipe full; the descriptor is readable anyway.
+        }
+    }
+
+    // Signals every idle source with queued messages. Returns non-zero when anything
+    // was signalled, so that wait_for_ready_types restarts its back-off.
+    DataTypes signal_ready_sources()
+    {
+        if (stopping)
+            return AllDataTypes;
+        DataTypes signalled = 0;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t n = 0; n < sources.size(); ++n) {
+            const Source &source = sources[n];
+            if (is_signalled(source))
+                continue;
+            const DataTypes ready = source.queued_types(source.data_types);
+            if (ready) {
+                signal(source);
+                signalled |= ready;
+            }
+        }
+        return signalled;
+    }
+
+    void run()
+    {
+        while (!stopping)
+            wait_for_ready_types([this]() { return signal_ready_sources(); }, std::chrono::seconds(1));
+    }
+
+    std::mutex mutex;
+    std::vector<Source> sources;
+    std::atomic<bool> stopping;
+    std::thread watcher;
+};
+
+} // namespace XeThru
+
+#endif // !_WIN32
+
+#endif // MESSAGENOTIFIER_HPP
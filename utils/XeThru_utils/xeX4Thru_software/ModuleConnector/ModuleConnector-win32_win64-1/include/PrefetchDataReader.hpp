@@ -0,0 +1,390 @@
+#ifndef PREFETCHDATAREADER_HPP
+#define PREFETCHDATAREADER_HPP
+
+#include "Data.hpp"
+#include "DataReader.hpp"
+#include "datatypes.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace XeThru {
+
+/**
+ * @class PrefetchDataReader
+ *
+ * The PrefetchDataReader class reads a recording like \ref DataReader, with a background
+ * thread reading ahead of the caller.
+ *
+ * When every record is followed by expensive processing, e.g. replaying a recording
+ * through a model, each page cache miss in \ref DataReader::read_record stalls the
+ * processing. PrefetchDataReader keeps a bounded queue of records filled from a
+ * background thread, so \ref read_record normally returns a record already in memory.
+ * The queue is bounded both in records and in bytes, see \ref set_read_ahead.
+ *
+ * \ref seek_ms and \ref seek_byte discard the queued records and restart reading at the
+ * new position. \ref set_filter applies from the next unread record: a narrower filter
+ * drops queued records that no longer match, a wider one restarts reading at the epoch
+ * of the last record returned, or at the position of the last open or seek if no record
+ * was returned since. In the former case, records of the added types with that same epoch
+ * are returned as well, even if they were stored before that record.
+ *
+ * @code
+ * PrefetchDataReader reader;
+ * reader.set_read_ahead(64, 16 * 1024 * 1024);
+ * if (reader.open(meta_filename) != 0)
+ *     return 1;
+ * while (!reader.at_end()) {
+ *     const DataRecord record = reader.read_record();
+ *     run_inference(record);
+ * }
+ * @endcode
+ *
+ * @see DataReader
+ */
+class PrefetchDataReader
+{
+public:
+    /**
+     * Constructs reader.
+     */
+    PrefetchDataReader() : max_records(32), max_bytes(8 * 1024 * 1024), queued_bytes(0),
+        filter(AllDataTypes), last_epoch(0), last_epoch_count(0), skip_epoch(0),
+        skip_filter(0), skip_count(0), origin(0), origin_is_byte(false), start_epoch(0), duration(0), size(0), data_types(0),
+        max_record_size(0), is_opened(false), skipping(false), stopping(false), done(false),
+        failed(false) {}
+
+    /**
+     * Destroys the reader, stopping the background thread.
+     */
+    ~PrefetchDataReader() { close(); }
+
+    /**
+     * Opens a recording and starts reading ahead, see \ref DataReader::open.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &meta_filename, int depth = -1)
+    {
+        close();
+        if (reader.open(meta_filename, depth) != 0 || reader.set_filter(filter) != 0) {
+            reader.close();
+            return 1;
+        }
+        start_epoch = reader.get_start_epoch();
+        duration = reader.get_duration();
+        size = reader.get_size();
+        data_types = reader.get_data_types();
+        max_record_size = reader.get_max_record_size();
+        session_id = reader.get_session_id();
+        set_origin(0, false);
+        is_opened = true;
+        start();
+        return 0;
+    }
+
+    /**
+     * @return true if the recording is successfully opened, otherwise returns false
+     */
+    bool is_open() const { return is_opened; }
+
+    /**
+     * Stops reading ahead and closes the recording.
+     */
+    void close()
+    {
+        stop();
+        clear();
+        reader.close();
+        is_opened = false;
+    }
+
+    /**
+     * Waits until the next record is read or the end of the recording is reached.
+     * @return true if no more data records is available for reading, otherwise returns false.
+     */
+    bool at_end()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wait_for_record(lock);
+        return records.empty();
+    }
+
+    /**
+     * Returns the next record, waiting for it to be read if necessary.
+     * DataRecord::is_valid is false at the end of the recording or when reading failed.
+     * @return the DataRecord.
+     */
+    DataRecord read_record()
+    {
+        DataRecord record;
+        read_record(&record);
+        return record;
+    }
+
+    /**
+     * Moves the next record into \a record, waiting for it to be read if necessary.
+     * @param[out] record Specifies the record to update.
+     * @return 0 on success, otherwise returns 1
+     */
+    int read_record(DataRecord *record)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wait_for_record(lock);
+        if (records.empty()) {
+            record->is_valid = false;
+            return 1;
+        }
+        std::swap(*record, records.front());
+        records.pop_front();
+        queued_bytes -= record->data.size();
+        if (record->epoch == last_epoch) {
+            ++last_epoch_count;
+        } else {
+            last_epoch = record->epoch;
+            last_epoch_count = 1;
+        }
+        lock.unlock();
+        space_ready.notify_one();
+        return 0;
+    }
+
+    /**
+     * Returns a copy of the next record without removing it, waiting for it to be read if necessary.
+     * @return the DataRecord.
+     */
+    DataRecord peek_record()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        wait_for_record(lock);
+        return records.empty() ? DataRecord() : records.front();
+    }
+
+    /**
+     * Discards the records read ahead and sets the current position, see \ref DataReader::seek_ms.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_ms(int64_t position)
+    {
+        stop();
+        clear();
+        set_origin(position, false);
+        const int status = reader.seek_ms(position);
+        start();
+        return status;
+    }
+
+    /**
+     * Discards the records read ahead and sets the current position, see \ref DataReader::seek_byte.
+     * @return 0 on success, otherwise returns 1
+     */
+    int seek_byte(int64_t position)
+    {
+        stop();
+        clear();
+        set_origin(position, true);
+        const int status = reader.seek_byte(position);
+        start();
+        return status;
+    }
+
+    /**
+     * Sets the filter, see \ref DataReader::set_filter. The filter applies from the next
+     * unread record.
+     * @return 0 success, otherwise returns 1
+     */
+    int set_filter(uint32_t data_types)
+    {
+        if (!is_opened) {
+            filter = data_types;
+            return 0;
+        }
+        stop();
+        int status = 0;
+        if ((data_types & ~filter) == 0) {
+            // Only records the caller no longer wants were read ahead.
+            for (std::deque<DataRecord>::iterator it = records.begin(); it != records.end();) {
+                if (it->data_type & data_types) {
+                    ++it;
+                } else {
+                    queued_bytes -= it->data.size();
+                    it = records.erase(it);
+                }
+            }
+            status = reader.set_filter(data_types);
+        } else if (last_epoch_count == 0) {
+            // Nothing was returned since the last open or seek; read again from there.
+            clear();
+            status = (origin_is_byte ? reader.seek_byte(origin) : reader.seek_ms(origin)) |
+                reader.set_filter(data_types);
+        } else {
+            // Records of the added types may precede the records read ahead; read again
+            // from the epoch of the last record returned, skipping what was already returned.
+            clear();
+            skip_epoch = last_epoch;
+            skip_filter = filter;
+            skip_count = last_epoch_count;
+            skipping = true;
+            status = reader.seek_ms(last_epoch - start_epoch) | reader.set_filter(data_types);
+        }
+        filter = data_types;
+        start();
+        return status;
+    }
+
+    /**
+     * @return the filter used by \ref read_record and \ref peek_record.
+     */
+    uint32_t get_filter() const { return filter; }
+
+    /**
+     * Sets how far to read ahead. Takes effect immediately.
+     * At least one record is read ahead even if it is larger than \a bytes.
+     * @param record_count Specifies the maximum number of records read ahead.
+     * @param bytes Specifies the maximum number of bytes read ahead.
+     */
+    void set_read_ahead(size_t record_count, size_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            max_records = record_count > 0 ? record_count : 1;
+            max_bytes = bytes;
+        }
+        space_ready.notify_one();
+    }
+
+    /**
+     * @return true if the background thread failed to read a record.
+     */
+    bool has_failed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return failed;
+    }
+
+    int64_t get_start_epoch() const { return start_epoch; }
+    int64_t get_duration() const { return duration; }
+    int64_t get_size() const { return size; }
+    uint32_t get_data_types() const { return data_types; }
+    uint32_t get_max_record_size() const { return max_record_size; }
+    std::string get_session_id() const { return session_id; }
+
+private:
+    PrefetchDataReader(const PrefetchDataReader &other) = delete;
+    PrefetchDataReader& operator= (const PrefetchDataReader &other) = delete;
+
+    void start()
+    {
+        stopping = false;
+        done = false;
+        failed = false;
+        worker = std::thread(&PrefetchDataReader::run, this);
+    }
+
+    // After stop() returns, only the calling thread uses the reader and the queue.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        space_ready.notify_one();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // Sets the position the last open or seek started reading at.
+    void set_origin(int64_t position, bool is_byte)
+    {
+        origin = position;
+        origin_is_byte = is_byte;
+        last_epoch_count = 0;
+    }
+
+    void clear()
+    {
+        records.clear();
+        queued_bytes = 0;
+        skipping = false;
+    }
+
+    void wait_for_record(std::unique_lock<std::mutex> &lock)
+    {
+        data_ready.wait(lock, [this]() { return !records.empty() || done || !is_opened; });
+    }
+
+    void run()
+    {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space_ready.wait(lock, [this]() {
+                    return stopping || records.empty() ||
+                        (records.size() < max_records && queued_bytes < max_bytes);
+                });
+                if (stopping)
+                    return;
+            }
+            DataRecord record;
+            const bool end = reader.at_end();
+            if (!end)
+                record = reader.read_record();
+            std::unique_lock<std::mutex> lock(mutex);
+            if (end || !record.is_valid) {
+                failed = !end;
+                done = true;
+                lock.unlock();
+                data_ready.notify_one();
+                return;
+            }
+            if (skipping) {
+                if (record.epoch < skip_epoch)
+                    continue;
+                if (record.epoch == skip_epoch && skip_count > 0 && (record.data_type & skip_filter)) {
+                    --skip_count;
+                    continue;
+                }
+                skipping = record.epoch == skip_epoch;
+            }
+            queued_bytes += record.data.size();
+            records.push_back(std::move(record));
+            lock.unlock();
+            data_ready.notify_one();
+        }
+    }
+
+    DataReader reader;
+    std::thread worker;
+    mutable std::mutex mutex;
+    std::condition_variable data_ready;
+    std::condition_variable space_ready;
+    std::deque<DataRecord> records;
+    size_t max_records;
+    size_t max_bytes;
+    size_t queued_bytes;
+    uint32_t filter;
+    int64_t last_epoch;
+    size_t last_epoch_count;
+    int64_t skip_epoch;
+    uint32_t skip_filter;
+    size_t skip_count;
+    int64_t origin;
+    bool origin_is_byte;
+    int64_t start_epoch;
+    int64_t duration;
+    int64_t size;
+    uint32_t data_types;
+    uint32_t max_record_size;
+    std::string session_id;
+    bool is_opened;
+    bool skipping;
+    bool stopping;
+    bool done;
+    bool failed;
+};
+
+} // namespace XeThru
+
+#endif // PREFETCHDATAREADER_HPP
@@ -0,0 +1,758 @@
+#ifndef RADARFRAMECODEC_HPP
+#define RADARFRAMECODEC_HPP
+
+#include "Bytes.hpp"
+#include "Data.hpp"
+#include "datatypes.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace XeThru {
+
+namespace detail {
+
+// Appends bits to a byte vector, least significant bit first.
+class BitWriter
+{
+public:
+    explicit BitWriter(Bytes &output) : out(output), acc(0), bits(0) {}
+
+    void put(uint32_t value, unsigned int count)
+    {
+        if (count == 0)
+            return;
+        acc |= static_cast<uint64_t>(value & (count == 32 ? 0xffffffffu : (1u << count) - 1)) << bits;
+        bits += count;
+        while (bits >= 8) {
+            out.push_back(static_cast<Byte>(acc));
+            acc >>= 8;
+            bits -= 8;
+        }
+    }
+
+    void flush()
+    {
+        if (bits > 0)
+            out.push_back(static_cast<Byte>(acc));
+        acc = 0;
+        bits = 0;
+    }
+
+private:
+    Bytes &out;
+    uint64_t acc;
+    unsigned int bits;
+};
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t *data, size_t size) : pos(data), end(data + size), acc(0), bits(0), ok(true) {}
+
+    uint32_t get(unsigned int count)
+    {
+        if (count == 0)
+            return 0;
+        while (bits < count) {
+            if (pos == end) {
+                ok = false;
+                return 0;
+            }
+            acc |= static_cast<uint64_t>(*pos++) << bits;
+            bits += 8;
+        }
+        const uint32_t value = static_cast<uint32_t>(acc & (count == 32 ? 0xffffffffu : (1u << count) - 1));
+        acc >>= count;
+        bits -= count;
+        return value;
+    }
+
+    bool is_ok() const { return ok; }
+
+private:
+    const uint8_t *pos;
+    const uint8_t *end;
+    uint64_t acc;
+    unsigned int bits;
+    bool ok;
+};
+
+inline unsigned int leading_zeros(uint32_t value)
+{
+#if defined(__GNUC__)
+    return value ? static_cast<unsigned int>(__builtin_clz(value)) : 32;
+#else
+    unsigned int count = 0;
+    for (uint32_t bit = 0x80000000u; bit && !(value & bit); bit >>= 1)
+        ++count;
+    return count;
+#endif
+}
+
+inline unsigned int trailing_zeros(uint32_t value)
+{
+#if defined(__GNUC__)
+    return value ? static_cast<unsigned int>(__builtin_ctz(value)) : 32;
+#else
+    unsigned int count = 0;
+    for (uint32_t bit = 1; bit && !(value & bit); bit <<= 1)
+        ++count;
+    return count;
+#endif
+}
+
+inline unsigned int bit_width(uint32_t value)
+{
+    return 32 - leading_zeros(value);
+}
+
+inline uint32_t load_u32(const uint8_t *data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline int16_t load_i16(const uint8_t *data)
+{
+    int16_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// Frame encodings.
+enum FrameMode
+{
+    RawFrame = 0,     // Bytes stored as is; starts a new reference frame.
+    XorFrame = 1,     // 32-bit words XORed with the previous frame, Gorilla style.
+    Q15DeltaFrame = 2 // Header words as XorFrame, int16 samples as bit-packed deltas.
+};
+
+// Number of header bytes of a RadarBasebandQ15Data record before the samples.
+static const uint32_t q15_header_size = 12 * 4;
+// Number of samples sharing one bit width.
+static const uint32_t q15_block_size = 16;
+
+} // namespace detail
+
+/**
+ * @class RadarFrameCodec
+ *
+ * Lossless codec for the records of a recording, tuned for radar frames.
+ *
+ * Consecutive frames of a radar data type differ little, so each record is coded against
+ * the previous record of the same data type:
+ * - Float and integer fields are XORed with the same 32-bit word of the previous frame.
+ *   Unchanged words cost one bit, others store only the bits between the leading and
+ *   trailing zeros of the XOR, as in the Gorilla time series encoding.
+ * - The int16 samples of \ref RadarBasebandQ15DataType records are coded as the
+ *   difference to the same sample of the previous frame, zigzag mapped and bit-packed in
+ *   blocks of 16 with one bit width per block.
+ *
+ * A record is stored as is when there is no previous record of its data type with the
+ * same size, e.g. the first record or after a change of frame area, and when coding it
+ * against the previous record would take more bytes. Records that are not a whole number
+ * of 32-bit words are always stored as is, so an encoded record is at most 5 bytes larger
+ * than the record.
+ *
+ * Encoder and decoder keep the previous frames, so a stream must be decoded in the order
+ * it was encoded, with one codec object per direction.
+ *
+ * @see CompressedDataWriter, CompressedDataReader
+ */
+class RadarFrameCodec
+{
+public:
+    RadarFrameCodec() : raw_bytes(0), encoded_bytes(0) {}
+
+    /**
+     * Forgets the previous frames, so that the next record of each data type is stored as is.
+     */
+    void reset()
+    {
+        for (int n = 0; n < 32; ++n)
+            previous[n].clear();
+        raw_bytes = 0;
+        encoded_bytes = 0;
+    }
+
+    /**
+     * Encodes a record, appending the encoded bytes to \a out.
+     * @param data_type Specifies the \ref DataType of the record.
+     * @param data Specifies the record bytes.
+     * @param size Specifies the number of record bytes.
+     * @param[out] out Specifies where to append the encoded record.
+     * @return 0 on success, otherwise returns 1
+     */
+    int encode(uint32_t data_type, const uint8_t *data, uint32_t size, Bytes *out)
+    {
+        const size_t start = out->size();
+        Bytes &reference = previous[detail::data_type_index(data_type)];
+        put_u32(*out, size);
+        if (reference.size() != size || size % 4 != 0) {
+            put_raw(*out, data, size);
+        } else if (data_type == RadarBasebandQ15DataType && size >= detail::q15_header_size) {
+            out->push_back(detail::Q15DeltaFrame);
+            detail::BitWriter writer(*out);
+            encode_xor(writer, data, reference.data(), detail::q15_header_size);
+            encode_q15(writer, data + detail::q15_header_size, reference.data() + detail::q15_header_size,
+                       (size - detail::q15_header_size) / 2);
+            writer.flush();
+        } else {
+            out->push_back(detail::XorFrame);
+            detail::BitWriter writer(*out);
+            encode_xor(writer, data, reference.data(), size);
+            writer.flush();
+        }
+        if (out->size() - start > size + 5) {
+            out->resize(start + 4);
+            put_raw(*out, data, size);
+        }
+        reference.assign(data, data + size);
+        raw_bytes += size;
+        encoded_bytes += out->size() - start;
+        return 0;
+    }
+
+    /**
+     * Decodes a record encoded by \ref encode.
+     * @param data_type Specifies the \ref DataType of the record.
+     * @param data Specifies the encoded bytes.
+     * @param size Specifies the number of encoded bytes.
+     * @param[out] out Specifies where to write the record, replacing its contents.
+     * @return 0 on success, otherwise returns 1
+     */
+    int decode(uint32_t data_type, const uint8_t *data, uint32_t size, Bytes *out)
+    {
+        if (size < 5)
+            return 1;
+        const uint32_t record_size = detail::load_u32(data);
+        const uint8_t mode = data[4];
+        data += 5;
+        size -= 5;
+        Bytes &reference = previous[detail::data_type_index(data_type)];
+        if (mode == detail::RawFrame) {
+            if (size != record_size)
+                return 1;
+            out->assign(data, data + size);
+        } else {
+            if (reference.size() != record_size || record_size % 4 != 0)
+                return 1;
+            out->resize(record_size);
+            detail::BitReader reader(data, size);
+            bool ok;
+            if (mode == detail::XorFrame) {
+                ok = decode_xor(reader, out->data(), reference.data(), record_size);
+            } else if (mode == detail::Q15DeltaFrame && record_size >= detail::q15_header_size) {
+                ok = decode_xor(reader, out->data(), reference.data(), detail::q15_header_size) &&
+                    decode_q15(reader, out->data() + detail::q15_header_size,
+                               reference.data() + detail::q15_header_size,
+                               (record_size - detail::q15_header_size) / 2);
+            } else {
+                ok = false;
+            }
+            if (!ok || !reader.is_ok())
+                return 1;
+        }
+        reference.assign(out->begin(), out->end());
+        raw_bytes += record_size;
+        encoded_bytes += size + 5;
+        return 0;
+    }
+
+    /**
+     * @return the number of record bytes encoded or decoded since construction or \ref reset.
+     */
+    uint64_t get_raw_bytes() const { return raw_bytes; }
+
+    /**
+     * @return the number of encoded bytes produced or consumed since construction or \ref reset.
+     */
+    uint64_t get_encoded_bytes() const { return encoded_bytes; }
+
+    /**
+     * @return the record bytes per encoded byte, or 1 if nothing was coded yet. Framing
+     * added by a container, e.g. the record headers of \ref CompressedDataWriter, is not
+     * included.
+     */
+    double get_compression_ratio() const
+    {
+        return encoded_bytes > 0 ? static_cast<double>(raw_bytes) / static_cast<double>(encoded_bytes) : 1.0;
+    }
+
+private:
+    static void put_u32(Bytes &out, uint32_t value)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(value));
+    }
+
+    static void put_raw(Bytes &out, const uint8_t *data, uint32_t size)
+    {
+        out.push_back(detail::RawFrame);
+        out.insert(out.end(), data, data + size);
+    }
+
+    // Gorilla style: 0 for an unchanged word; 10 and the meaningful bits when they fit
+    // in the previous window; 11, 5 bits leading zeros, 5 bits length - 1 and the bits.
+    static void encode_xor(detail::BitWriter &writer, const uint8_t *data, const uint8_t *reference, uint32_t size)
+    {
+        unsigned int window_leading = 32;
+        unsigned int window_trailing = 0;
+        for (uint32_t n = 0; n < size; n += 4) {
+            const uint32_t value = detail::load_u32(data + n) ^ detail::load_u32(reference + n);
+            if (value == 0) {
+                writer.put(0, 1);
+                continue;
+            }
+            const unsigned int leading = detail::leading_zeros(value);
+            const unsigned int trailing = detail::trailing_zeros(value);
+            if (leading >= window_leading && trailing >= window_trailing) {
+                writer.put(1, 2);
+                writer.put(value >> window_trailing, 32 - window_leading - window_trailing);
+            } else {
+                window_leading = leading;
+                window_trailing = trailing;
+                const unsigned int length = 32 - leading - trailing;
+                writer.put(3, 2);
+                writer.put(leading, 5);
+                writer.put(length - 1, 5);
+                writer.put(value >> trailing, length);
+            }
+        }
+    }
+
+    static bool decode_xor(detail::BitReader &reader, uint8_t *out, const uint8_t *reference, uint32_t size)
+    {
+        unsigned int window_leading = 32;
+        unsigned int window_trailing = 0;
+        for (uint32_t n = 0; n < size; n += 4) {
+            uint32_t value = 0;
+            if (reader.get(1)) {
+                if (reader.get(1)) {
+                    window_leading = reader.get(5);
+                    const unsigned int length = reader.get(5) + 1;
+                    if (window_leading + length > 32)
+                        return false;
+                    window_trailing = 32 - window_leading - length;
+                }
+                value = reader.get(32 - window_leading - window_trailing) << window_trailing;
+            }
+            value ^= detail::load_u32(reference + n);
+            std::memcpy(out + n, &value, sizeof(value));
+        }
+        return true;
+    }
+
+    static void encode_q15(detail::BitWriter &writer, const uint8_t *data, const uint8_t *reference, uint32_t count)
+    {
+        uint32_t deltas[detail::q15_block_size];
+        for (uint32_t block = 0; block < count; block += detail::q15_block_size) {
+            const uint32_t block_count = std::min<uint32_t>(detail::q15_block_size, count - block);
+            uint32_t all = 0;
+            for (uint32_t n = 0; n < block_count; ++n) {
+                const int32_t delta = static_cast<int32_t>(detail::load_i16(data + 2 * (block + n))) -
+                    detail::load_i16(reference + 2 * (block + n));
+                deltas[n] = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+                all |= deltas[n];
+            }
+            const unsigned int width = detail::bit_width(all);
+            writer.put(width, 5);
+            for (uint32_t n = 0; n < block_count; ++n)
+                writer.put(deltas[n], width);
+        }
+    }
+
+    static bool decode_q15(detail::BitReader &reader, uint8_t *out, const uint8_t *reference, uint32_t count)
+    {
+        for (uint32_t block = 0; block < count; block += detail::q15_block_size) {
+            const uint32_t block_count = std::min<uint32_t>(detail::q15_block_size, count - block);
+            const unsigned int width = reader.get(5);
+            if (width > 17)
+                return false;
+            for (uint32_t n = 0; n < block_count; ++n) {
+                const uint32_t zigzag = reader.get(width);
+                const int32_t delta = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+                const int16_t value = static_cast<int16_t>(detail::load_i16(reference + 2 * (block + n)) + delta);
+                std::memcpy(out + 2 * (block + n), &value, sizeof(value));
+            }
+        }
+        return true;
+    }
+
+    Bytes previous[32];
+    uint64_t raw_bytes;
+    uint64_t encoded_bytes;
+};
+
+namespace detail {
+
+static const char compressed_recording_magic[8] = { 'X', 'T', 'R', 'E', 'C', 'Z', 'I', 'P' };
+static const uint32_t compressed_recording_version = 2;
+static const uint32_t compressed_recording_header_size = sizeof(compressed_recording_magic) + 4;
+
+// Precedes each encoded record in a compressed recording file. Stored field by field as
+// epoch, data_type, encoded_size and is_user_header, without padding.
+struct CompressedRecordHeader
+{
+    int64_t epoch;
+    uint32_t data_type;
+    uint32_t encoded_size;
+    uint32_t is_user_header;
+
+    static const size_t stored_size = 8 + 3 * 4;
+
+    void store(uint8_t *out) const
+    {
+        std::memcpy(out, &epoch, 8);
+        std::memcpy(out + 8, &data_type, 4);
+        std::memcpy(out + 12, &encoded_size, 4);
+        std::memcpy(out + 16, &is_user_header, 4);
+    }
+
+    void load(const uint8_t *in)
+    {
+        std::memcpy(&epoch, in, 8);
+        std::memcpy(&data_type, in + 8, 4);
+        std::memcpy(&encoded_size, in + 12, 4);
+        std::memcpy(&is_user_header, in + 16, 4);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @class CompressedDataWriter
+ *
+ * Writes records to a compressed recording file using \ref RadarFrameCodec.
+ *
+ * A compressed recording is a single file holding the records of a recording with their
+ * data type and epoch, e.g. as converted from a \ref DataReader. It is read back with
+ * \ref CompressedDataReader. The file starts with a 12 byte header, and each record is
+ * stored as a 20 byte record header and the encoded record. User headers are stored as is.
+ *
+ * @code
+ * DataReader reader;
+ * CompressedDataWriter writer;
+ * reader.open(meta_filename);
+ * writer.open(meta_filename + ".xtz");
+ * while (!reader.at_end())
+ *     writer.write_record(reader.read_record());
+ * writer.close();
+ * @endcode
+ */
+class CompressedDataWriter
+{
+public:
+    CompressedDataWriter() : file(nullptr), record_bytes(0), file_bytes(0) {}
+    ~CompressedDataWriter() { close(); }
+
+    /**
+     * Creates the compressed recording file, replacing an existing file.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &filename)
+    {
+        close();
+        codec.reset();
+        record_bytes = 0;
+        file_bytes = detail::compressed_recording_header_size;
+        file = std::fopen(filename.c_str(), "wb");
+        if (!file)
+            return 1;
+        const uint32_t version = detail::compressed_recording_version;
+        if (std::fwrite(detail::compressed_recording_magic, sizeof(detail::compressed_recording_magic), 1, file) != 1 ||
+            std::fwrite(&version, sizeof(version), 1, file) != 1) {
+            close();
+            return 1;
+        }
+        return 0;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    /**
+     * Closes the file.
+     * @return 0 on success, otherwise returns 1
+     */
+    int close()
+    {
+        if (!file)
+            return 0;
+        const int status = std::fclose(file) == 0 ? 0 : 1;
+        file = nullptr;
+        return status;
+    }
+
+    /**
+     * Encodes and writes a record.
+     * @return 0 on success, otherwise returns 1
+     */
+    int write_record(uint32_t data_type, int64_t epoch, const uint8_t *data, uint32_t size, bool is_user_header)
+    {
+        if (!file)
+            return 1;
+        encoded.clear();
+        if (is_user_header) {
+            encoded.assign(data, data + size);
+        } else if (codec.encode(data_type, data, size, &encoded) != 0) {
+            return 1;
+        }
+        detail::CompressedRecordHeader header;
+        header.epoch = epoch;
+        header.data_type = data_type;
+        header.encoded_size = static_cast<uint32_t>(encoded.size());
+        header.is_user_header = is_user_header ? 1 : 0;
+        uint8_t stored[detail::CompressedRecordHeader::stored_size];
+        header.store(stored);
+        if (std::fwrite(stored, sizeof(stored), 1, file) != 1 ||
+            (!encoded.empty() && std::fwrite(encoded.data(), encoded.size(), 1, file) != 1))
+            return 1;
+        record_bytes += size;
+        file_bytes += sizeof(stored) + encoded.size();
+        return 0;
+    }
+
+    /**
+     * Encodes and writes a record.
+     * @return 0 on success, otherwise returns 1
+     */
+    int write_record(const DataRecord &record)
+    {
+        if (!record.is_valid)
+            return 1;
+        return write_record(record.data_type, record.epoch, record.data.data(),
+                            static_cast<uint32_t>(record.data.size()), record.is_user_header);
+    }
+
+    /**
+     * @return the number of record bytes written, including user headers, i.e. the size
+     * of the data files holding the same records.
+     */
+    uint64_t get_record_bytes() const { return record_bytes; }
+
+    /**
+     * @return the number of bytes written to the file, including the file and record headers.
+     */
+    uint64_t get_file_bytes() const { return file_bytes; }
+
+    /**
+     * @return the record bytes per file byte, i.e. \ref get_record_bytes / \ref get_file_bytes,
+     * or 1 if no record was written. Unlike \ref RadarFrameCodec::get_compression_ratio, this
+     * includes the record headers and the user header records.
+     */
+    double get_compression_ratio() const
+    {
+        return record_bytes > 0 ? static_cast<double>(record_bytes) / static_cast<double>(file_bytes) : 1.0;
+    }
+
+private:
+    CompressedDataWriter(const CompressedDataWriter &other) = delete;
+    CompressedDataWriter& operator= (const CompressedDataWriter &other) = delete;
+
+    std::FILE *file;
+    RadarFrameCodec codec;
+    Bytes encoded;
+    uint64_t record_bytes;
+    uint64_t file_bytes;
+};
+
+/**
+ * @class CompressedDataReader
+ *
+ * Reads a compressed recording file written by \ref CompressedDataWriter, with the record
+ * reading API of \ref DataReader.
+ *
+ * A record that cannot be read or decoded, e.g. at the end of a file truncated by a crash
+ * while writing, ends the reading: \ref at_end returns true and \ref has_failed tells it
+ * apart from the end of the file.
+ */
+class CompressedDataReader
+{
+public:
+    CompressedDataReader() : file(nullptr), filter(AllDataTypes), has_next(false), failed(false), record_bytes(0), file_bytes(0) {}
+    ~CompressedDataReader() { close(); }
+
+    /**
+     * Opens a compressed recording file.
+     * @return 0 on success, otherwise returns 1
+     */
+    int open(const std::string &filename)
+    {
+        close();
+        codec.reset();
+        failed = false;
+        record_bytes = 0;
+        file_bytes = detail::compressed_recording_header_size;
+        file = std::fopen(filename.c_str(), "rb");
+        if (!file)
+            return 1;
+        char magic[sizeof(detail::compressed_recording_magic)];
+        uint32_t version;
+        if (std::fread(magic, sizeof(magic), 1, file) != 1 ||
+            std::memcmp(magic, detail::compressed_recording_magic, sizeof(magic)) != 0 ||
+            std::fread(&version, sizeof(version), 1, file) != 1 ||
+            version != detail::compressed_recording_version) {
+            close();
+            return 1;
+        }
+        read_header();
+        return 0;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    void close()
+    {
+        if (file)
+            std::fclose(file);
+        file = nullptr;
+        has_next = false;
+    }
+
+    /**
+     * @return true if no more data records is available for reading, otherwise returns false.
+     */
+    bool at_end()
+    {
+        skip_filtered();
+        return !has_next;
+    }
+
+    /**
+     * @return true if a record could not be read or decoded, which ended the reading,
+     * otherwise returns false.
+     */
+    bool has_failed() const { return failed; }
+
+    /**
+     * Reads and decodes the next record matching the filter into \a record, reusing its storage.
+     * @return 0 on success, otherwise returns 1
+     */
+    int read_record(DataRecord *record)
+    {
+        record->is_valid = false;
+        skip_filtered();
+        if (!has_next)
+            return 1;
+        if (!read_payload()) {
+            fail();
+            return 1;
+        }
+        if (next.is_user_header) {
+            record->data.assign(encoded.begin(), encoded.end());
+        } else if (codec.decode(next.data_type, encoded.data(), next.encoded_size, &record->data) != 0) {
+            fail();
+            return 1;
+        }
+        record_bytes += record->data.size();
+        record->data_type = next.data_type;
+        record->epoch = next.epoch;
+        record->is_user_header = next.is_user_header != 0;
+        record->meta_version = 0;
+        record->is_valid = true;
+        read_header();
+        return 0;
+    }
+
+    /**
+     * Reads and decodes the next record matching the filter.
+     * @return the DataRecord, with DataRecord::is_valid false at the end or on error.
+     */
+    DataRecord read_record()
+    {
+        DataRecord record;
+        read_record(&record);
+        return record;
+    }
+
+    /**
+     * Sets the data types returned by \ref read_record, see \ref DataReader::set_filter.
+     * @return 0 success, otherwise returns 1
+     */
+    int set_filter(uint32_t data_types)
+    {
+        filter = data_types;
+        return 0;
+    }
+
+    uint32_t get_filter() const { return filter; }
+
+    /**
+     * @return the record bytes per file byte of the records read, including skipped records,
+     * see \ref CompressedDataWriter::get_compression_ratio.
+     */
+    double get_compression_ratio() const
+    {
+        return record_bytes > 0 ? static_cast<double>(record_bytes) / static_cast<double>(file_bytes) : 1.0;
+    }
+
+private:
+    CompressedDataReader(const CompressedDataReader &other) = delete;
+    CompressedDataReader& operator= (const CompressedDataReader &other) = delete;
+
+    // Reads the header of the next record. A partial header is a truncated file.
+    void read_header()
+    {
+        uint8_t stored[detail::CompressedRecordHeader::stored_size];
+        const size_t count = file ? std::fread(stored, 1, sizeof(stored), file) : 0;
+        has_next = count == sizeof(stored);
+        if (has_next)
+            next.load(stored);
+        else if (count != 0 || (file && std::ferror(file)))
+            fail();
+    }
+
+    void fail()
+    {
+        failed = true;
+        has_next = false;
+    }
+
+    bool read_payload()
+    {
+        encoded.resize(next.encoded_size);
+        if (next.encoded_size != 0 && std::fread(encoded.data(), next.encoded_size, 1, file) != 1)
+            return false;
+        file_bytes += detail::CompressedRecordHeader::stored_size + next.encoded_size;
+        return true;
+    }
+
+    // Records of other types are still decoded, since later records are coded against them.
+    void skip_filtered()
+    {
+        while (has_next && !(next.data_type & filter)) {
+            if (!read_payload()) {
+                fail();
+                return;
+            }
+            if (next.is_user_header) {
+                record_bytes += next.encoded_size;
+            } else if (codec.decode(next.data_type, encoded.data(), next.encoded_size, &skipped) != 0) {
+                fail();
+                return;
+            } else {
+                record_bytes += skipped.size();
+            }
+            read_header();
+        }
+    }
+
+    std::FILE *file;
+    RadarFrameCodec codec;
+    uint32_t filter;
+    detail::CompressedRecordHeader next;
+    bool has_next;
+    bool failed;
+    Bytes encoded;
+    Bytes skipped;
+    uint64_t record_bytes;
+    uint64_t file_bytes;
+};
+
+} // namespace XeThru
+
+#endif // RADARFRAMECODEC_HPP
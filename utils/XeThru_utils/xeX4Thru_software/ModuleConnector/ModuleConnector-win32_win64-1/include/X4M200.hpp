@@ -5,7 +5,9 @@
 #include "Data.hpp"
 #include "Bytes.hpp"
 #include "LockedRadarForward.hpp"
+#include "MessageWait.hpp"
 
+#include <chrono>
 #include <cinttypes>
 #include <string>
 #include <vector>
@@ -484,6 +486,58 @@ public:
      */
     int read_message_noisemap_byte(PulseDopplerByteData *data);
 
+    /**
+     * Returns which of the given data types have messages queued.
+     *
+     * @param data_types: bitmask of DataType flags to check. Supported flags are
+     * BasebandApDataType, BasebandIqDataType, RespirationDataType, SleepDataType, RespirationMovingListDataType, RespirationDetectionListDataType, RespirationNormalizedMovementListDataType, VitalSignsDataType, PulseDopplerFloatDataType, PulseDopplerByteDataType, NoiseMapFloatDataType, NoiseMapByteDataType.
+     * @return the subset of data_types with at least one queued message
+     */
+    DataTypes queued_message_types(DataTypes data_types)
+    {
+        DataTypes ready = 0;
+        if ((data_types & BasebandApDataType) && peek_message_baseband_ap() > 0)
+            ready |= BasebandApDataType;
+        if ((data_types & BasebandIqDataType) && peek_message_baseband_iq() > 0)
+            ready |= BasebandIqDataType;
+        if ((data_types & RespirationDataType) && peek_message_respiration_legacy() > 0)
+            ready |= RespirationDataType;
+        if ((data_types & SleepDataType) && peek_message_respiration_sleep() > 0)
+            ready |= SleepDataType;
+        if ((data_types & RespirationMovingListDataType) && peek_message_respiration_movinglist() > 0)
+            ready |= RespirationMovingListDataType;
+        if ((data_types & RespirationDetectionListDataType) && peek_message_respiration_detectionlist() > 0)
+            ready |= RespirationDetectionListDataType;
+        if ((data_types & RespirationNormalizedMovementListDataType) && peek_message_respiration_normalizedmovementlist() > 0)
+            ready |= RespirationNormalizedMovementListDataType;
+        if ((data_types & VitalSignsDataType) && peek_message_vital_signs() > 0)
+            ready |= VitalSignsDataType;
+        if ((data_types & PulseDopplerFloatDataType) && peek_message_pulsedoppler_float() > 0)
+            ready |= PulseDopplerFloatDataType;
+        if ((data_types & PulseDopplerByteDataType) && peek_message_pulsedoppler_byte() > 0)
+            ready |= PulseDopplerByteDataType;
+        if ((data_types & NoiseMapFloatDataType) && peek_message_noisemap_float() > 0)
+            ready |= NoiseMapFloatDataType;
+        if ((data_types & NoiseMapByteDataType) && peek_message_noisemap_byte() > 0)
+            ready |= NoiseMapByteDataType;
+        return ready;
+    }
+
+    /**
+     * Waits until a message of one of the given data types is queued, or the timeout expires.
+     * Use this instead of polling the peek_message_* functions in a loop.
+     *
+     * @param data_types: bitmask of DataType flags to wait for, for example
+     * SleepDataType | BasebandIqDataType. See \ref queued_message_types for supported flags.
+     * @param timeout: maximum time to wait
+     * @return the subset of data_types with queued messages, or 0 on timeout
+     */
+    DataTypes wait_for_message(DataTypes data_types, std::chrono::microseconds timeout)
+    {
+        return wait_for_ready_types([this, data_types]() { return queued_message_types(data_types); },
+                                    timeout);
+    }
+
     /**
      * Send command to module to load a previously stored noisemap
      *